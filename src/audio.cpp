@@ -0,0 +1,100 @@
+/*
+  RG350 Test
+  Audio device of the mixer: opened in one place with any rate and
+  buffer size, and a postmix callback shared by the audio tests.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include "audio.h"
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct audio_hookslot
+{
+  audio_hook hook;
+  void* udata;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+audio_device audio;
+static audio_hookslot audio_hooks[AUDIO_HOOKS];
+
+///////////////////////////////////
+/*  Postmix callback, runs in    */
+/*  the audio thread after every */
+/*  buffer is mixed              */
+///////////////////////////////////
+static void audio_postmix(void* udata, Uint8* stream, int len)
+{
+  for(int f=0;f<AUDIO_HOOKS;f++)
+    if(audio_hooks[f].hook)
+      audio_hooks[f].hook(audio_hooks[f].udata,stream,len);
+}
+
+///////////////////////////////////
+/*  Open the mixer, 1 if ok      */
+///////////////////////////////////
+int audio_open(int rate, int samples)
+{
+  Uint16 format;
+  audio_close();
+  if(Mix_OpenAudio(rate,AUDIO_S16SYS,MIX_DEFAULT_CHANNELS,samples)<0)
+    return 0;
+  if(!Mix_QuerySpec(&audio.rate,&format,&audio.channels))
+  {
+    Mix_CloseAudio();
+    return 0;
+  }
+  audio.samples=samples;
+  audio.opened=1;
+  Mix_SetPostMix(audio_postmix,NULL);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Close the mixer              */
+///////////////////////////////////
+void audio_close()
+{
+  if(!audio.opened)
+    return;
+  Mix_HaltChannel(-1);
+  Mix_SetPostMix(NULL,NULL);
+  Mix_CloseAudio();
+  audio.opened=0;
+}
+
+///////////////////////////////////
+/*  Add a postmix hook           */
+///////////////////////////////////
+void audio_addhook(audio_hook hook, void* udata)
+{
+  SDL_LockAudio();
+  for(int f=0;f<AUDIO_HOOKS;f++)
+  {
+    if(!audio_hooks[f].hook)
+    {
+      audio_hooks[f].udata=udata;
+      audio_hooks[f].hook=hook;
+      break;
+    }
+  }
+  SDL_UnlockAudio();
+}
+
+///////////////////////////////////
+/*  Remove a postmix hook        */
+///////////////////////////////////
+void audio_removehook(audio_hook hook)
+{
+  SDL_LockAudio();
+  for(int f=0;f<AUDIO_HOOKS;f++)
+    if(audio_hooks[f].hook==hook)
+      audio_hooks[f].hook=NULL;
+  SDL_UnlockAudio();
+}
@@ -0,0 +1,46 @@
+/*
+  RG350 Test
+  Audio device of the mixer: opened in one place with any rate and
+  buffer size, and a postmix callback shared by the audio tests.
+*/
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+
+#define AUDIO_RATE      MIX_DEFAULT_FREQUENCY
+#define AUDIO_SAMPLES   1024
+#define AUDIO_HOOKS     4
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+typedef void (*audio_hook)(void* udata, Uint8* stream, int len);
+
+struct audio_device
+{
+  int opened;
+  int rate;               // given by the mixer
+  int channels;
+  int samples;            // requested buffer size
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern audio_device audio;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+int audio_open(int rate, int samples);
+void audio_close();
+void audio_addhook(audio_hook hook, void* udata);
+void audio_removehook(audio_hook hook);
+
+#endif
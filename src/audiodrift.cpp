@@ -0,0 +1,111 @@
+/*
+  RG350 Test
+  Audio clock drift: samples taken by the mixer against the monotonic
+  clock for some minutes, the slope is the real rate of the codec.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <math.h>
+#include "timing.h"
+#include "audio.h"
+#include "audiodrift.h"
+
+#define AUDIODRIFT_WARMUP  500000ULL   // us before measuring, the device is filling
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+audio_drift drift_results;
+
+///////////////////////////////////
+/*  Samples and time of every    */
+/*  callback                     */
+///////////////////////////////////
+static void audiodrift_hook(void* udata, Uint8* stream, int len)
+{
+  audio_drift* test=(audio_drift*)udata;
+  unsigned long long now=time_us();
+
+  // samples played before this buffer, minus the nominal rate,
+  // small numbers so the sums keep their precision
+  if(now-test->start>=AUDIODRIFT_WARMUP)
+  {
+    double x=(now-test->start)/1000000.0;
+    double y=test->samples-x*test->rate;
+    test->n++;
+    test->sx+=x;
+    test->sy+=y;
+    test->sxx+=x*x;
+    test->sxy+=x*y;
+    test->syy+=y*y;
+  }
+  test->samples+=len/(2*test->channels);
+}
+
+///////////////////////////////////
+/*  Start the test               */
+///////////////////////////////////
+void audiodrift_start(audio_drift& test)
+{
+  audiodrift_stop(test);
+  if(!audio.opened)
+  {
+    test.status=3;
+    return;
+  }
+  test.rate=audio.rate;
+  test.channels=audio.channels;
+  test.samples=0;
+  test.n=test.sx=test.sy=test.sxx=test.sxy=test.syy=0;
+  test.seconds=0;
+  test.real_rate=0;
+  test.ppm=0;
+  test.error_ppm=0;
+  test.start=time_us();
+  test.status=1;
+  audio_addhook(audiodrift_hook,&test);
+}
+
+///////////////////////////////////
+/*  Called every frame, update   */
+/*  the slope of samples against */
+/*  time                         */
+///////////////////////////////////
+void audiodrift_step(audio_drift& test)
+{
+  if(test.status!=1)
+    return;
+
+  SDL_LockAudio();
+  double n=test.n,sx=test.sx,sy=test.sy,sxx=test.sxx,sxy=test.sxy,syy=test.syy;
+  SDL_UnlockAudio();
+  test.seconds=(time_us()-test.start)/1000000.0;
+
+  double vx=n*sxx-sx*sx;
+  if(n>2 && vx>0)
+  {
+    double slope=(n*sxy-sx*sy)/vx;
+    double residual=(syy-(sy*sy)/n-slope*(sxy-sx*sy/n))/(n-2);
+    test.real_rate=test.rate+slope;
+    test.ppm=slope*1000000.0/test.rate;
+    test.error_ppm=residual>0?sqrt(residual*n/vx)*1000000.0/test.rate:0;
+  }
+  if(test.seconds>=AUDIODRIFT_TIME)
+  {
+    audio_removehook(audiodrift_hook);
+    test.status=2;
+  }
+}
+
+///////////////////////////////////
+/*  Stop the test, before the    */
+/*  mixer is opened again        */
+///////////////////////////////////
+void audiodrift_stop(audio_drift& test)
+{
+  audio_removehook(audiodrift_hook);
+  if(test.status==1)
+    test.status=0;
+}
@@ -0,0 +1,43 @@
+/*
+  RG350 Test
+  Audio clock drift: samples taken by the mixer against the monotonic
+  clock for some minutes, the slope is the real rate of the codec.
+*/
+
+#ifndef AUDIODRIFT_H
+#define AUDIODRIFT_H
+
+#define AUDIODRIFT_TIME  180   // seconds playing
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct audio_drift
+{
+  int status;             // 0=not run, 1=running, 2=done, 3=mixer not open
+  int rate;               // nominal rate of the mixer
+  int channels;
+  unsigned long long start;
+  // written by the audio thread
+  unsigned long long samples;   // sample frames played
+  double n,sx,sy,sxx,sxy,syy;   // sums of seconds and samples over the nominal rate
+  // updated every frame
+  double seconds;
+  double real_rate;
+  double ppm;             // deviation from nominal
+  double error_ppm;       // standard error of the slope
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern audio_drift drift_results;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void audiodrift_start(audio_drift& test);
+void audiodrift_step(audio_drift& test);
+void audiodrift_stop(audio_drift& test);
+
+#endif
@@ -0,0 +1,134 @@
+/*
+  RG350 Test
+  Audio latency test: the mixer is opened with every buffer size and
+  sample rate, the callbacks are timed to find jitter and underruns.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <math.h>
+#include "timing.h"
+#include "audio.h"
+#include "audiotest.h"
+
+#define AUDIOTEST_TIME     1000   // ms measuring every config
+#define AUDIOTEST_WARMUP   4      // callbacks before measuring, the device is filling
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+audio_test audio_results;
+const int audiotest_rates[AUDIOTEST_RATES]={22050,44100,48000};
+const int audiotest_buffers[AUDIOTEST_BUFFERS]={128,256,512,1024,2048,4096};
+
+///////////////////////////////////
+/*  Time of every callback       */
+///////////////////////////////////
+static void audiotest_hook(void* udata, Uint8* stream, int len)
+{
+  audio_test* test=(audio_test*)udata;
+  if(test->count<AUDIOTEST_CALLBACKS)
+  {
+    test->times[test->count]=time_us();
+    test->count++;
+  }
+}
+
+///////////////////////////////////
+/*  Open the next config that    */
+/*  works, 0 if there aren't     */
+/*  more                         */
+///////////////////////////////////
+static int audiotest_open(audio_test& test)
+{
+  for(;test.current<AUDIOTEST_RATES*AUDIOTEST_BUFFERS;test.current++)
+  {
+    audiotest_result& result=test.results[test.current/AUDIOTEST_BUFFERS][test.current%AUDIOTEST_BUFFERS];
+    result.ok=0;
+    audio_close();
+    test.count=0;
+    if(!audio_open(audiotest_rates[test.current/AUDIOTEST_BUFFERS],audiotest_buffers[test.current%AUDIOTEST_BUFFERS]))
+      continue;
+    test.start=time_us();
+    return 1;
+  }
+  return 0;
+}
+
+///////////////////////////////////
+/*  Intervals of the callbacks   */
+///////////////////////////////////
+static void audiotest_analyze(audio_test& test, audiotest_result& result)
+{
+  result.ok=1;
+  result.rate=audio.rate;
+  result.period_ms=audio.samples*1000.0/audio.rate;
+  // SDL mixes a buffer while the device plays the one before
+  result.latency_ms=2*result.period_ms;
+  result.callbacks=0;
+  result.interval_ms=0;
+  result.jitter_ms=0;
+  result.max_ms=0;
+  result.underruns=0;
+  result.safe=0;
+
+  double sum=0,squares=0;
+  for(int f=AUDIOTEST_WARMUP+1;f<test.count;f++)
+  {
+    double interval=(test.times[f]-test.times[f-1])/1000.0;
+    double error=interval-result.period_ms;
+    sum+=interval;
+    squares+=error*error;
+    if(interval>result.max_ms)
+      result.max_ms=interval;
+    // the device played all its buffer before the next one was ready
+    if(interval>result.period_ms*1.5)
+      result.underruns++;
+    result.callbacks++;
+  }
+  if(result.callbacks==0)
+    return;
+  result.interval_ms=sum/result.callbacks;
+  result.jitter_ms=sqrt(squares/result.callbacks);
+  result.safe=result.underruns==0 && result.jitter_ms<result.period_ms/4;
+}
+
+///////////////////////////////////
+/*  Start the test               */
+///////////////////////////////////
+void audiotest_start(audio_test& test)
+{
+  test.current=0;
+  audio_addhook(audiotest_hook,&test);
+  if(!audiotest_open(test))
+  {
+    audio_removehook(audiotest_hook);
+    audio_open(AUDIO_RATE,AUDIO_SAMPLES);
+    test.status=2;
+    return;
+  }
+  test.status=1;
+}
+
+///////////////////////////////////
+/*  Called every frame, change   */
+/*  the config when its time is  */
+/*  over                         */
+///////////////////////////////////
+void audiotest_step(audio_test& test)
+{
+  if(test.status!=1 || time_us()-test.start<AUDIOTEST_TIME*1000ULL)
+    return;
+
+  // the audio thread is stopped, times can be read
+  audio_close();
+  audiotest_analyze(test,test.results[test.current/AUDIOTEST_BUFFERS][test.current%AUDIOTEST_BUFFERS]);
+  test.current++;
+  if(audiotest_open(test))
+    return;
+
+  audio_removehook(audiotest_hook);
+  audio_open(AUDIO_RATE,AUDIO_SAMPLES);
+  test.status=2;
+}
@@ -0,0 +1,54 @@
+/*
+  RG350 Test
+  Audio latency test: the mixer is opened with every buffer size and
+  sample rate, the callbacks are timed to find jitter and underruns.
+*/
+
+#ifndef AUDIOTEST_H
+#define AUDIOTEST_H
+
+#define AUDIOTEST_RATES      3
+#define AUDIOTEST_BUFFERS    6
+#define AUDIOTEST_CALLBACKS  1024   // callback times kept for every config
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct audiotest_result
+{
+  int ok;                 // 0=config not available
+  int rate;               // given by the mixer
+  int callbacks;          // measured
+  double period_ms;       // time of a buffer
+  double interval_ms;     // mean time between callbacks
+  double jitter_ms;       // RMS of the interval against the period
+  double max_ms;          // longest interval
+  int underruns;          // intervals longer than a buffer and a half
+  double latency_ms;      // buffer of the callback and buffer of the device
+  int safe;               // no underruns and small jitter
+};
+
+struct audio_test
+{
+  int status;             // 0=not run, 1=running, 2=done
+  int current;            // config being measured
+  unsigned long long start;
+  volatile int count;     // written by the audio thread
+  unsigned long long times[AUDIOTEST_CALLBACKS];
+  audiotest_result results[AUDIOTEST_RATES][AUDIOTEST_BUFFERS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern audio_test audio_results;
+extern const int audiotest_rates[AUDIOTEST_RATES];
+extern const int audiotest_buffers[AUDIOTEST_BUFFERS];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void audiotest_start(audio_test& test);
+void audiotest_step(audio_test& test);
+
+#endif
@@ -0,0 +1,500 @@
+/*
+  RG350 Test
+  Battery level from a table of voltage against charge measured in a
+  full discharge of the unit. The discharge is logged to a ring file,
+  the voltage is smoothed and the time left estimated from the drop.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "timing.h"
+#include "battery.h"
+
+#define BATTERY_MAGIC       0x31424752   // "RGB1"
+#define BATTERY_LUTMAGIC    0x314C4752   // "RGL1"
+#define BATTERY_MINMV       3310         // linear table, as the old level
+#define BATTERY_MAXMV       4200
+#define BATTERY_USBMV       65           // voltage raised by the charger
+#define BATTERY_EMA         0.05         // of every read, 2 s apart
+#define BATTERY_RESET       120          // s without reads to start again the average
+#define BATTERY_LOGPERIOD   10           // s between records
+#define BATTERY_SYNCEVERY   6            // records between syncs of the log
+#define BATTERY_RATETIME    300          // s between measures of the drop
+#define BATTERY_GAP         120          // s without records that ends a discharge
+#define BATTERY_FULLMV      4050         // first record of a full discharge
+#define BATTERY_EMPTYMV     3500         // last record
+#define BATTERY_MINRUN      1800         // s of the shortest discharge used
+#define BATTERY_SMOOTH      6            // records averaged each side
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+// 32 bytes at the start of the log
+struct battery_header
+{
+  Uint32 magic;
+  Uint32 capacity;        // records
+  Uint32 head;            // next record written
+  Uint32 count;
+  Uint32 session;         // logs started
+  Uint32 period_s;
+  Uint32 reserved;
+  Uint32 check;
+};
+
+// 12 bytes every record
+struct battery_record
+{
+  Uint32 time;            // seconds since 1970
+  Uint16 mv;
+  Sint16 ma;              // 0 if not given
+  Uint16 charging;
+  Uint16 session;
+};
+
+struct battery_table
+{
+  Uint32 magic;
+  Sint32 mv[BATTERY_LUTPOINTS];
+  Uint32 runtime_s;
+  Uint32 time;            // when it was built
+  Uint32 check;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+battery_state battery;
+
+static int battery_log=-1;
+static battery_header battery_head;
+static unsigned long long battery_readtime=0;
+static unsigned long long battery_logtime=0;
+static int battery_unsynced=0;
+// the card is synced by a thread, not in the frame
+static pthread_t battery_syncth;
+static pthread_mutex_t battery_syncmutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t battery_synccond=PTHREAD_COND_INITIALIZER;
+static int battery_syncpending=0;
+static int battery_syncquit=0;
+static unsigned long long battery_ratetime=0;
+static double battery_ratepercent=0;
+static double battery_rate=0;   // % per second, 0 unknown
+
+///////////////////////////////////
+/*  FNV-1a                       */
+///////////////////////////////////
+static Uint32 battery_check(const void* data, int size)
+{
+  const unsigned char* bytes=(const unsigned char*)data;
+  Uint32 hash=2166136261U;
+  for(int f=0;f<size;f++)
+    hash=(hash^bytes[f])*16777619U;
+  return hash;
+}
+
+///////////////////////////////////
+/*  Number from a sysfs file     */
+///////////////////////////////////
+static int battery_sysfs(const char* path, int& value)
+{
+  FILE* fd=fopen(path,"r");
+  if(!fd)
+    return 0;
+  int ok=fscanf(fd,"%d",&value)==1;
+  fclose(fd);
+  return ok;
+}
+
+///////////////////////////////////
+/*  Straight table between the   */
+/*  old limits                   */
+///////////////////////////////////
+static void battery_linear()
+{
+  for(int f=0;f<BATTERY_LUTPOINTS;f++)
+    battery.lut_mv[f]=BATTERY_MINMV+(BATTERY_MAXMV-BATTERY_MINMV)*f/(BATTERY_LUTPOINTS-1);
+  battery.lut_measured=0;
+  battery.lut_runtime_s=0;
+}
+
+///////////////////////////////////
+/*  Percent of a voltage         */
+///////////////////////////////////
+static double battery_lookup(double mv)
+{
+  const int* lut=battery.lut_mv;
+  if(mv<=lut[0])
+    return 0;
+  if(mv>=lut[BATTERY_LUTPOINTS-1])
+    return 100;
+  int f;
+  for(f=0;f<BATTERY_LUTPOINTS-2 && mv>=lut[f+1];f++);
+  double step=100.0/(BATTERY_LUTPOINTS-1);
+  if(lut[f+1]==lut[f])
+    return f*step;
+  return (f+(mv-lut[f])/(lut[f+1]-lut[f]))*step;
+}
+
+///////////////////////////////////
+/*  Thread that syncs the log    */
+/*  when asked, and at the end   */
+///////////////////////////////////
+static void* battery_syncthd(void* p)
+{
+  pthread_mutex_lock(&battery_syncmutex);
+  while(1)
+  {
+    while(!battery_syncpending && !battery_syncquit)
+      pthread_cond_wait(&battery_synccond,&battery_syncmutex);
+    int quit=battery_syncquit;
+    battery_syncpending=0;
+    pthread_mutex_unlock(&battery_syncmutex);
+    fdatasync(battery_log);
+    if(quit)
+      return NULL;
+    pthread_mutex_lock(&battery_syncmutex);
+  }
+}
+
+///////////////////////////////////
+/*  Header of the log            */
+///////////////////////////////////
+static int battery_writehead()
+{
+  battery_head.check=battery_check(&battery_head,sizeof(battery_head)-sizeof(battery_head.check));
+  return pwrite(battery_log,&battery_head,sizeof(battery_head),0)==sizeof(battery_head);
+}
+
+///////////////////////////////////
+/*  Add a record to the ring     */
+///////////////////////////////////
+static void battery_logrecord(int mv, int ma, int charging)
+{
+  unsigned long long start=time_us();
+  battery_record record;
+  record.time=(Uint32)time(NULL);
+  record.mv=(Uint16)mv;
+  record.ma=(Sint16)(ma<-32768?-32768:(ma>32767?32767:ma));
+  record.charging=(Uint16)charging;
+  record.session=(Uint16)battery_head.session;
+  off_t offset=sizeof(battery_head)+(off_t)battery_head.head*sizeof(record);
+  if(pwrite(battery_log,&record,sizeof(record),offset)!=sizeof(record))
+    return;
+  battery_head.head=(battery_head.head+1)%battery_head.capacity;
+  if(battery_head.count<battery_head.capacity)
+    battery_head.count++;
+  battery_writehead();
+  // the card isn't written every record, a minute can be lost
+  if(++battery_unsynced>=BATTERY_SYNCEVERY)
+  {
+    pthread_mutex_lock(&battery_syncmutex);
+    battery_syncpending=1;
+    pthread_cond_signal(&battery_synccond);
+    pthread_mutex_unlock(&battery_syncmutex);
+    battery_unsynced=0;
+  }
+  battery.logged=battery_head.count;
+  battery.log_us=(unsigned int)(time_us()-start);
+  if(battery.log_us>battery.log_max_us)
+    battery.log_max_us=battery.log_us;
+}
+
+///////////////////////////////////
+/*  Load the table of the unit   */
+///////////////////////////////////
+void battery_init()
+{
+  battery_table table;
+  memset(&battery,0,sizeof(battery));
+  battery.minutes_left=-1;
+  battery_linear();
+  int fd=open(BATTERY_LUTFILE,O_RDONLY);
+  if(fd<0)
+    return;
+  if(read(fd,&table,sizeof(table))==sizeof(table) && table.magic==BATTERY_LUTMAGIC &&
+    table.check==battery_check(&table,sizeof(table)-sizeof(table.check)))
+  {
+    for(int f=0;f<BATTERY_LUTPOINTS;f++)
+      battery.lut_mv[f]=table.mv[f];
+    battery.lut_measured=1;
+    battery.lut_runtime_s=table.runtime_s;
+  }
+  close(fd);
+}
+
+///////////////////////////////////
+/*  Read the battery, every 2 s. */
+/*  Returns the level            */
+///////////////////////////////////
+int battery_read(int charging)
+{
+  int microvolts;
+  if(!battery_sysfs("/sys/class/power_supply/battery/voltage_now",microvolts))
+    return battery.level;
+  if(!battery_sysfs("/sys/class/power_supply/battery/current_now",battery.microamps))
+    battery.microamps=0;
+  battery.microvolts=microvolts;
+  unsigned long long now=time_us();
+  double mv=microvolts/1000.0;
+  if(charging)
+    mv-=BATTERY_USBMV;
+
+  // exponential average, started again after a sleep
+  if(battery.ema_mv==0 || now-battery_readtime>BATTERY_RESET*1000000ULL)
+    battery.ema_mv=mv;
+  else
+    battery.ema_mv+=(mv-battery.ema_mv)*BATTERY_EMA;
+  battery_readtime=now;
+  battery.percent=battery_lookup(battery.ema_mv);
+  battery.level=(int)(battery.percent+0.5);
+
+  // time left from the drop of the last minutes
+  if(charging || battery_ratetime==0)
+  {
+    battery_ratetime=now;
+    battery_ratepercent=battery.percent;
+    if(charging)
+      battery_rate=0;
+  }
+  else if(now-battery_ratetime>=BATTERY_RATETIME*1000000ULL)
+  {
+    double drop=(battery_ratepercent-battery.percent)/((now-battery_ratetime)/1000000.0);
+    if(drop>0)
+      battery_rate=battery_rate>0?battery_rate*0.7+drop*0.3:drop;
+    battery_ratetime=now;
+    battery_ratepercent=battery.percent;
+  }
+  if(charging)
+    battery.minutes_left=-1;
+  else if(battery_rate>0)
+    battery.minutes_left=(int)(battery.percent/battery_rate/60);
+  else if(battery.lut_measured)
+    battery.minutes_left=(int)(battery.percent*battery.lut_runtime_s/100/60);
+  else
+    battery.minutes_left=-1;
+
+  if(battery.logging && now-battery_logtime>=BATTERY_LOGPERIOD*1000000ULL)
+  {
+    battery_logtime=now;
+    battery_logrecord(microvolts/1000,battery.microamps/1000,charging);
+  }
+  return battery.level;
+}
+
+///////////////////////////////////
+/*  Start logging, the ring is   */
+/*  kept between sessions        */
+///////////////////////////////////
+int battery_logstart()
+{
+  if(battery.logging)
+    return 1;
+  battery_log=open(BATTERY_LOGFILE,O_RDWR | O_CREAT,0644);
+  if(battery_log<0)
+    return 0;
+  if(read(battery_log,&battery_head,sizeof(battery_head))!=sizeof(battery_head) || battery_head.magic!=BATTERY_MAGIC ||
+    battery_head.capacity!=BATTERY_LOGSIZE || battery_head.head>=BATTERY_LOGSIZE || battery_head.count>BATTERY_LOGSIZE ||
+    battery_head.check!=battery_check(&battery_head,sizeof(battery_head)-sizeof(battery_head.check)))
+  {
+    memset(&battery_head,0,sizeof(battery_head));
+    battery_head.magic=BATTERY_MAGIC;
+    battery_head.capacity=BATTERY_LOGSIZE;
+    battery_head.period_s=BATTERY_LOGPERIOD;
+  }
+  battery_head.session++;
+  battery_syncpending=0;
+  battery_syncquit=0;
+  if(!battery_writehead() || pthread_create(&battery_syncth,NULL,battery_syncthd,NULL)!=0)
+  {
+    close(battery_log);
+    battery_log=-1;
+    return 0;
+  }
+  battery.logging=1;
+  battery.logged=battery_head.count;
+  battery.log_max_us=0;
+  battery_logtime=0;
+  battery_unsynced=0;
+  return 1;
+}
+
+///////////////////////////////////
+/*  Stop logging                 */
+///////////////////////////////////
+void battery_logstop()
+{
+  if(!battery.logging)
+    return;
+  // last sync in the thread
+  pthread_mutex_lock(&battery_syncmutex);
+  battery_syncquit=1;
+  pthread_cond_signal(&battery_synccond);
+  pthread_mutex_unlock(&battery_syncmutex);
+  pthread_join(battery_syncth,NULL);
+  close(battery_log);
+  battery_log=-1;
+  battery.logging=0;
+}
+
+///////////////////////////////////
+/*  Build the table from the     */
+/*  longest full discharge of    */
+/*  the log, 1 if saved          */
+///////////////////////////////////
+int battery_buildlut()
+{
+  battery_header header;
+  int f;
+
+  int fd=open(BATTERY_LOGFILE,O_RDONLY);
+  if(fd<0)
+  {
+    strcpy(battery.message,"No log.");
+    return 0;
+  }
+  // records not synced yet are read from the page cache
+  battery_record* records=(battery_record*)malloc(BATTERY_LOGSIZE*sizeof(battery_record));
+  double* smooth=(double*)malloc(BATTERY_LOGSIZE*sizeof(double));
+  double* left=(double*)malloc(BATTERY_LOGSIZE*sizeof(double));
+  int count=0;
+  if(records && smooth && left && read(fd,&header,sizeof(header))==sizeof(header) && header.magic==BATTERY_MAGIC &&
+    header.capacity==BATTERY_LOGSIZE && header.count<=BATTERY_LOGSIZE && header.head<BATTERY_LOGSIZE)
+  {
+    // oldest record first
+    int first=header.count<header.capacity?0:header.head;
+    for(f=0;f<(int)header.count;f++)
+    {
+      off_t offset=sizeof(header)+(off_t)((first+f)%header.capacity)*sizeof(battery_record);
+      if(pread(fd,&records[count],sizeof(battery_record),offset)!=sizeof(battery_record))
+        break;
+      count++;
+    }
+  }
+  close(fd);
+
+  // discharges: records of a session without charger or gaps
+  int best_start=-1,best_end=-1;
+  unsigned int best_time=0;
+  for(int start=0;start<count;)
+  {
+    int end=start;
+    if(!records[start].charging)
+      while(end+1<count && !records[end+1].charging && records[end+1].session==records[start].session &&
+        records[end+1].time>=records[end].time && records[end+1].time-records[end].time<=BATTERY_GAP)
+        end++;
+    unsigned int length=records[end].time-records[start].time;
+    if(!records[start].charging && records[start].mv>=BATTERY_FULLMV && records[end].mv<=BATTERY_EMPTYMV &&
+      length>=BATTERY_MINRUN && length>best_time)
+    {
+      best_start=start;
+      best_end=end;
+      best_time=length;
+    }
+    start=end+1;
+  }
+  if(best_start<0)
+  {
+    sprintf(battery.message,"No full discharge in %i records.",count);
+    free(records);
+    free(smooth);
+    free(left);
+    return 0;
+  }
+
+  // charge left at every record: by the current when the driver gives
+  // it, else by the time left at the same load
+  int samples=best_end-best_start+1;
+  battery_record* run=records+best_start;
+  int with_current=0;
+  for(f=0;f<samples;f++)
+    if(run[f].ma!=0)
+      with_current++;
+  left[samples-1]=0;
+  for(f=samples-2;f>=0;f--)
+  {
+    double seconds=run[f+1].time-run[f].time;
+    if(with_current>samples/2)
+      left[f]=left[f+1]+abs(run[f].ma)*seconds;
+    else
+      left[f]=left[f+1]+seconds;
+  }
+  double total=left[0];
+  for(f=0;f<samples;f++)
+  {
+    left[f]=total>0?left[f]*100/total:0;
+    // voltage averaged against the load steps
+    int from=f>BATTERY_SMOOTH?f-BATTERY_SMOOTH:0;
+    int to=f+BATTERY_SMOOTH<samples?f+BATTERY_SMOOTH:samples-1;
+    double sum=0;
+    for(int s=from;s<=to;s++)
+      sum+=run[s].mv;
+    smooth[f]=sum/(to-from+1);
+  }
+
+  // voltage where the charge left crosses every point
+  battery_table table;
+  memset(&table,0,sizeof(table));
+  table.magic=BATTERY_LUTMAGIC;
+  table.runtime_s=best_time;
+  table.time=(Uint32)time(NULL);
+  int s=0;
+  for(f=BATTERY_LUTPOINTS-1;f>=0;f--)
+  {
+    double percent=100.0*f/(BATTERY_LUTPOINTS-1);
+    while(s<samples-1 && left[s]>percent)
+      s++;
+    if(s==0 || left[s-1]==left[s])
+      table.mv[f]=(Sint32)smooth[s];
+    else
+      table.mv[f]=(Sint32)(smooth[s-1]+(smooth[s]-smooth[s-1])*(left[s-1]-percent)/(left[s-1]-left[s]));
+  }
+  // voltage can't go down while the charge goes up
+  for(f=1;f<BATTERY_LUTPOINTS;f++)
+    if(table.mv[f]<table.mv[f-1])
+      table.mv[f]=table.mv[f-1];
+  table.check=battery_check(&table,sizeof(table)-sizeof(table.check));
+  free(records);
+  free(smooth);
+  free(left);
+
+  // temporary file and rename, a cut table isn't loaded
+  char temp[]=BATTERY_LUTFILE ".tmp";
+  int out=open(temp,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  int ok=out>=0;
+  if(ok)
+  {
+    ok=write(out,&table,sizeof(table))==sizeof(table);
+    if(fsync(out)<0)
+      ok=0;
+    close(out);
+  }
+  if(!ok || rename(temp,BATTERY_LUTFILE)<0)
+  {
+    unlink(temp);
+    strcpy(battery.message,"Can't save the table.");
+    return 0;
+  }
+  for(f=0;f<BATTERY_LUTPOINTS;f++)
+    battery.lut_mv[f]=table.mv[f];
+  battery.lut_measured=1;
+  battery.lut_runtime_s=table.runtime_s;
+  sprintf(battery.message,"Table from %.1f h, %s.",best_time/3600.0,with_current>samples/2?"current":"time");
+  return 1;
+}
+
+///////////////////////////////////
+/*  Close the log                */
+///////////////////////////////////
+void battery_end()
+{
+  battery_logstop();
+}
@@ -0,0 +1,59 @@
+/*
+  RG350 Test
+  Battery level from a table of voltage against charge measured in a
+  full discharge of the unit. The discharge is logged to a ring file,
+  the voltage is smoothed and the time left estimated from the drop.
+*/
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define BATTERY_LOGFILE    "/usr/local/home/rg350test_battery.bin"
+#define BATTERY_LUTFILE    "/usr/local/home/rg350test_battery.lut"
+#define BATTERY_LUTPOINTS  21        // every 5 %
+#define BATTERY_LOGSIZE    8192      // records in the ring, a day at 10 s
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct battery_state
+{
+  int microvolts;         // last read
+  int microamps;          // 0 if the driver doesn't give it
+  double ema_mv;          // smoothed voltage, 0 until the first read
+  double percent;         // from the table, with decimals
+  int level;              // %
+  int minutes_left;       // -1 unknown or charging
+  // table
+  int lut_mv[BATTERY_LUTPOINTS];   // voltage at 0, 5 ... 100 %
+  int lut_measured;       // 0=linear table
+  unsigned int lut_runtime_s;      // length of the discharge measured
+  // logger
+  int logging;
+  unsigned int logged;    // records in the ring
+  unsigned int log_us;    // last write of a record
+  unsigned int log_max_us;
+  char message[48];       // result of the last table build
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern battery_state battery;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void battery_init();
+int battery_read(int charging);
+int battery_logstart();
+void battery_logstop();
+int battery_buildlut();
+void battery_end();
+
+#endif
@@ -0,0 +1,315 @@
+/*
+  RG350 Test
+  CPU micro-benchmarks. Every kernel runs for a fixed time and the
+  result is also divided by the clock, so two units at the same MHz
+  can be compared.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "timing.h"
+#include "cpubench.h"
+
+#define BENCH_BUFSIZE   (1024*1024)   // bigger than the 256 KiB L2 of the JZ4770
+#define BENCH_TIME      250           // ms running every kernel
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+bench_result bench_results[BENCH_COUNT];
+const char* bench_names[BENCH_COUNT]={
+"alu",
+"branch",
+"fpu",
+"memcpy",
+"memset",
+"interp"
+};
+int bench_score=0;
+
+static pthread_t bench_th;
+static int bench_running=0;
+static int bench_finished=0;
+static volatile int bench_stop=0;
+static int bench_mhz=0;
+static unsigned char* bench_src=NULL;
+static unsigned char* bench_dst=NULL;
+volatile unsigned int bench_sink;   // keep the compiler from removing the kernels
+
+///////////////////////////////////
+/*  Integer ALU, 8 ops per loop  */
+///////////////////////////////////
+static unsigned int kernel_alu(unsigned int loops)
+{
+  unsigned int a=bench_sink+1,b=12345,c=67890,d=0;
+  while(loops--)
+  {
+    a=a*1103515245+b;
+    b^=a>>7;
+    c+=b<<3;
+    d-=c|a;
+  }
+  return a+b+c+d;
+}
+
+///////////////////////////////////
+/*  Unpredictable branches,      */
+/*  one branch per loop          */
+///////////////////////////////////
+static unsigned int kernel_branch(unsigned int loops)
+{
+  unsigned int lfsr=0xACE1u+bench_sink,a=0,b=0;
+  while(loops--)
+  {
+    lfsr=(lfsr>>1) ^ (-(lfsr & 1u) & 0xB400u);
+    if(lfsr & 1)
+      a+=lfsr;
+    else
+      b^=lfsr;
+  }
+  return a+b;
+}
+
+///////////////////////////////////
+/*  Floating point multiply-add, */
+/*  8 flops per loop             */
+///////////////////////////////////
+static unsigned int kernel_fpu(unsigned int loops)
+{
+  double a=1.0+bench_sink,b=1.1,c=1.2,d=1.3;
+  const double m=0.999999,k=0.000001;
+  while(loops--)
+  {
+    a=a*m+k;
+    b=b*m+k;
+    c=c*m+k;
+    d=d*m+k;
+  }
+  return (unsigned int)(a+b+c+d);
+}
+
+///////////////////////////////////
+/*  Memory copy of the buffer    */
+///////////////////////////////////
+static unsigned int kernel_memcpy(unsigned int loops)
+{
+  while(loops--)
+    memcpy(bench_dst,bench_src,BENCH_BUFSIZE);
+  return bench_dst[bench_sink & (BENCH_BUFSIZE-1)];
+}
+
+///////////////////////////////////
+/*  Memory fill of the buffer    */
+///////////////////////////////////
+static unsigned int kernel_memset(unsigned int loops)
+{
+  while(loops--)
+    memset(bench_dst,loops,BENCH_BUFSIZE);
+  return bench_dst[bench_sink & (BENCH_BUFSIZE-1)];
+}
+
+///////////////////////////////////
+/*  Small bytecode interpreter,  */
+/*  like the dispatch loop of an */
+/*  emulator core                */
+///////////////////////////////////
+#define OP_LOAD   0
+#define OP_ADD    1
+#define OP_XOR    2
+#define OP_SHL    3
+#define OP_STORE  4
+#define OP_DEC    5
+#define OP_JNZ    6
+#define OP_END    7
+
+static const unsigned char interp_program[]={
+OP_LOAD,0,
+OP_ADD,1,
+OP_XOR,2,
+OP_SHL,1,
+OP_STORE,3,
+OP_ADD,3,
+OP_DEC,0,
+OP_JNZ,0,
+OP_END,0
+};
+#define INTERP_OPS 32  // instructions executed in every pass of the program (4 loops)
+
+static unsigned int kernel_interp(unsigned int loops)
+{
+  unsigned int regs[4]={0,bench_sink,0x5A5A,0};
+  unsigned int acc=0,counter;
+  const unsigned char* pc;
+
+  while(loops--)
+  {
+    counter=4;
+    pc=interp_program;
+    while(1)
+    {
+      unsigned char arg=pc[1];
+      switch(pc[0])
+      {
+        case OP_LOAD:  acc=regs[arg]; break;
+        case OP_ADD:   acc+=regs[arg]; break;
+        case OP_XOR:   acc^=regs[arg]; break;
+        case OP_SHL:   acc<<=(arg & 31); break;
+        case OP_STORE: regs[arg]=acc; break;
+        case OP_DEC:   counter--; break;
+        case OP_JNZ:
+          if(counter)
+          {
+            pc=interp_program+arg;
+            continue;
+          }
+          break;
+        default:
+          goto end_program;
+      }
+      pc+=2;
+    }
+end_program:
+    regs[1]+=acc;
+  }
+  return regs[1]+regs[3];
+}
+
+///////////////////////////////////
+/*  Run a kernel for some time,  */
+/*  return Mops/s (MB/s for      */
+/*  memory kernels). Ends early  */
+/*  when *stop is set            */
+///////////////////////////////////
+double cpubench_kernel(int kernel, int time_ms, const volatile int* stop)
+{
+  unsigned int loops;
+  double ops_per_loop;
+  unsigned int (*run)(unsigned int);
+
+  switch(kernel)
+  {
+    case BENCH_ALU:    run=kernel_alu;    loops=100000; ops_per_loop=8; break;
+    case BENCH_BRANCH: run=kernel_branch; loops=100000; ops_per_loop=1; break;
+    case BENCH_FPU:    run=kernel_fpu;    loops=100000; ops_per_loop=8; break;
+    case BENCH_MEMCPY: run=kernel_memcpy; loops=1;      ops_per_loop=BENCH_BUFSIZE; break;
+    case BENCH_MEMSET: run=kernel_memset; loops=1;      ops_per_loop=BENCH_BUFSIZE; break;
+    case BENCH_INTERP: run=kernel_interp; loops=10000;  ops_per_loop=INTERP_OPS; break;
+    default: return 0;
+  }
+
+  if(kernel==BENCH_MEMCPY || kernel==BENCH_MEMSET)
+  {
+    if(!bench_src)
+      bench_src=(unsigned char*)malloc(BENCH_BUFSIZE);
+    if(!bench_dst)
+      bench_dst=(unsigned char*)malloc(BENCH_BUFSIZE);
+    if(!bench_src || !bench_dst)
+      return 0;
+    memset(bench_src,0x55,BENCH_BUFSIZE);
+  }
+
+  // warm up caches and cpufreq, then count loops until time is over
+  bench_sink+=run(loops);
+  double total=0;
+  unsigned long long start=time_us();
+  unsigned long long elapsed=0;
+  while(elapsed<(unsigned long long)time_ms*1000 && !*stop)
+  {
+    bench_sink+=run(loops);
+    total+=loops;
+    elapsed=time_us()-start;
+  }
+  if(elapsed==0)
+    return 0;
+  return total*ops_per_loop/elapsed;
+}
+
+///////////////////////////////////
+/*  Thread that run all kernels  */
+///////////////////////////////////
+static void* cpubench_thd(void* p)
+{
+  double product=1;
+  int f;
+
+  for(f=0;f<BENCH_COUNT;f++)
+    bench_results[f].status=0;
+  for(f=0;f<BENCH_COUNT && !bench_stop;f++)
+  {
+    bench_results[f].status=1;
+    bench_results[f].mops=cpubench_kernel(f,BENCH_TIME,&bench_stop);
+    bench_results[f].per_mhz=(bench_mhz>0)?bench_results[f].mops/bench_mhz:0;
+    bench_results[f].status=2;
+    product*=bench_results[f].per_mhz;
+  }
+
+  // geometric mean of ops per cycle, x100, no score without the clock
+  if(!bench_stop && bench_mhz>0)
+    bench_score=(int)(pow(product,1.0/BENCH_COUNT)*100+0.5);
+  bench_finished=1;
+  return NULL;
+}
+
+///////////////////////////////////
+/*  Start benchmarks in          */
+/*  background                   */
+///////////////////////////////////
+void cpubench_start(int mhz)
+{
+  if(bench_running)
+  {
+    if(!bench_finished)
+      return;
+    pthread_join(bench_th,NULL);
+    bench_running=0;
+  }
+  bench_mhz=mhz;
+  bench_stop=0;
+  bench_finished=0;
+  bench_score=0;
+  if(pthread_create(&bench_th,NULL,cpubench_thd,NULL)==0)
+    bench_running=1;
+}
+
+///////////////////////////////////
+/*  1 when all kernels ended     */
+///////////////////////////////////
+int cpubench_done()
+{
+  return !bench_running || bench_finished;
+}
+
+///////////////////////////////////
+/*  Wait for the kernels, so     */
+/*  nothing else runs with them  */
+///////////////////////////////////
+void cpubench_wait()
+{
+  if(!bench_running)
+    return;
+  pthread_join(bench_th,NULL);
+  bench_running=0;
+}
+
+///////////////////////////////////
+/*  Stop benchmarks thread, free */
+/*  buffers                      */
+///////////////////////////////////
+void cpubench_end()
+{
+  if(bench_running)
+  {
+    bench_stop=1;
+    pthread_join(bench_th,NULL);
+    bench_running=0;
+  }
+  free(bench_src);
+  free(bench_dst);
+  bench_src=NULL;
+  bench_dst=NULL;
+}
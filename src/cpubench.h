@@ -0,0 +1,48 @@
+/*
+  RG350 Test
+  CPU micro-benchmarks. Every kernel runs for a fixed time and the
+  result is also divided by the clock, so two units at the same MHz
+  can be compared.
+*/
+
+#ifndef CPUBENCH_H
+#define CPUBENCH_H
+
+///////////////////////////////////
+/*  Kernels                      */
+///////////////////////////////////
+#define BENCH_ALU      0
+#define BENCH_BRANCH   1
+#define BENCH_FPU      2
+#define BENCH_MEMCPY   3
+#define BENCH_MEMSET   4
+#define BENCH_INTERP   5
+#define BENCH_COUNT    6
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct bench_result
+{
+  int status;       // 0=not run, 1=running, 2=done
+  double mops;      // million operations (bytes for memory kernels) per second
+  double per_mhz;   // operations per clock cycle
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern bench_result bench_results[BENCH_COUNT];
+extern const char* bench_names[BENCH_COUNT];
+extern int bench_score;   // all kernels together, 0 until finished or if the clock is unknown
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+double cpubench_kernel(int kernel, int time_ms, const volatile int* stop);
+void cpubench_start(int mhz);
+int cpubench_done();
+void cpubench_wait();
+void cpubench_end();
+
+#endif
@@ -0,0 +1,267 @@
+/*
+  RG350 Test
+  CPU frequency, read from cpufreq sysfs, and frequency sweep: runs a
+  benchmark kernel at every cpufreq step.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "cpubench.h"
+#include "cpufreq.h"
+
+#define SWEEP_TIME        200   // ms running every kernel at every step
+#define SWEEP_GOVSTEPS    8     // steps recorded when the clock can't be forced
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+cpufreq_sweep freq_sweep;
+
+static char cpufreq_root[128]=CPUFREQ_ROOT;
+static pthread_t sweep_th;
+static int sweep_running=0;
+static volatile int sweep_stop=0;
+
+///////////////////////////////////
+/*  Change sysfs folder          */
+///////////////////////////////////
+void cpufreq_setroot(const char* path)
+{
+  strncpy(cpufreq_root,path,sizeof(cpufreq_root)-1);
+  cpufreq_root[sizeof(cpufreq_root)-1]=0;
+}
+
+///////////////////////////////////
+/*  Read a value in kHz, return  */
+/*  -1 if not available          */
+///////////////////////////////////
+int cpufreq_read(const char* file)
+{
+  char path[192];
+  int value=-1;
+
+  sprintf(path,"%s/%s",cpufreq_root,file);
+  FILE* handle=fopen(path,"r");
+  if(handle)
+  {
+    if(fscanf(handle,"%d",&value)!=1)
+      value=-1;
+    fclose(handle);
+  }
+  return value;
+}
+
+///////////////////////////////////
+/*  Write a value in kHz         */
+///////////////////////////////////
+static int cpufreq_write(const char* file, int value)
+{
+  char path[192];
+
+  sprintf(path,"%s/%s",cpufreq_root,file);
+  FILE* handle=fopen(path,"w");
+  if(!handle)
+    return 0;
+  int ok=fprintf(handle,"%d\n",value)>0;
+  // sysfs reports the error when the file is closed
+  if(fclose(handle)!=0)
+    ok=0;
+  return ok;
+}
+
+///////////////////////////////////
+/*  Read available steps in kHz, */
+/*  sorted from low to high      */
+///////////////////////////////////
+int cpufreq_available(int* khz, int max)
+{
+  char path[192];
+  int count=0;
+  int value;
+
+  sprintf(path,"%s/scaling_available_frequencies",cpufreq_root);
+  FILE* handle=fopen(path,"r");
+  if(!handle)
+    return 0;
+  while(count<max && fscanf(handle,"%d",&value)==1)
+    khz[count++]=value;
+  fclose(handle);
+
+  // insertion sort, there are only a few steps
+  for(int f=1;f<count;f++)
+  {
+    int g=f;
+    value=khz[f];
+    while(g>0 && khz[g-1]>value)
+    {
+      khz[g]=khz[g-1];
+      g--;
+    }
+    khz[g]=value;
+  }
+  return count;
+}
+
+///////////////////////////////////
+/*  Force a clock, keeping       */
+/*  min<=max in every write      */
+///////////////////////////////////
+static int cpufreq_force(int khz, int lowest)
+{
+  return cpufreq_write("scaling_min_freq",lowest) &&
+         cpufreq_write("scaling_max_freq",khz) &&
+         cpufreq_write("scaling_min_freq",khz);
+}
+
+///////////////////////////////////
+/*  Measure a step               */
+///////////////////////////////////
+static void sweep_measure(cpufreq_step& step)
+{
+  step.alu=cpubench_kernel(BENCH_ALU,SWEEP_TIME,&sweep_stop);
+  step.mem=cpubench_kernel(BENCH_MEMCPY,SWEEP_TIME,&sweep_stop);
+  step.real_mhz=cpufreq_read("cpuinfo_cur_freq")/1000;
+  if(step.mhz<=0)
+    step.mhz=step.real_mhz;
+  step.slow_cpu=0;
+  step.slow_mem=0;
+}
+
+///////////////////////////////////
+/*  Flag steps where throughput  */
+/*  doesn't scale with the clock */
+///////////////////////////////////
+static void sweep_flag(cpufreq_sweep& sweep)
+{
+  double best=0;
+  int f;
+
+  // alu work per MHz should be constant, lower means throttling
+  for(f=0;f<sweep.count;f++)
+    if(sweep.steps[f].mhz>0 && sweep.steps[f].alu/sweep.steps[f].mhz>best)
+      best=sweep.steps[f].alu/sweep.steps[f].mhz;
+  for(f=0;f<sweep.count;f++)
+    if(sweep.steps[f].mhz>0 && sweep.steps[f].alu/sweep.steps[f].mhz<best*0.9)
+      sweep.steps[f].slow_cpu=1;
+
+  // memory doesn't scale linearly, flag when it grows less than half the clock
+  for(f=1;f<sweep.count;f++)
+  {
+    cpufreq_step& prev=sweep.steps[f-1];
+    cpufreq_step& step=sweep.steps[f];
+    if(prev.mhz<=0 || prev.mem<=0 || step.mhz<=prev.mhz)
+      continue;
+    double clock_gain=(double)step.mhz/prev.mhz-1;
+    double mem_gain=step.mem/prev.mem-1;
+    if(mem_gain<clock_gain*0.5)
+      step.slow_mem=1;
+  }
+}
+
+///////////////////////////////////
+/*  Thread that run the sweep    */
+///////////////////////////////////
+static void* cpufreq_sweep_thd(void* p)
+{
+  int khz[CPUFREQ_MAXSTEPS];
+  int count=cpufreq_available(khz,CPUFREQ_MAXSTEPS);
+  int saved_min=cpufreq_read("scaling_min_freq");
+  int saved_max=cpufreq_read("scaling_max_freq");
+
+  freq_sweep.count=0;
+  freq_sweep.writable=0;
+  if(count>0 && saved_min>0 && saved_max>0)
+    freq_sweep.writable=cpufreq_force(khz[0],khz[0]);
+
+  if(freq_sweep.writable)
+  {
+    for(int f=0;f<count && !sweep_stop;f++)
+    {
+      cpufreq_step& step=freq_sweep.steps[freq_sweep.count];
+      if(!cpufreq_force(khz[f],khz[0]))
+        continue;
+      usleep(50000);  // let the clock settle
+      step.mhz=khz[f]/1000;
+      sweep_measure(step);
+      freq_sweep.count++;
+    }
+    // restore governor limits
+    cpufreq_write("scaling_min_freq",khz[0]);
+    cpufreq_write("scaling_max_freq",saved_max);
+    cpufreq_write("scaling_min_freq",saved_min);
+  }
+  else
+  {
+    // no permission, record the clocks the governor chooses
+    for(int f=0;f<SWEEP_GOVSTEPS && !sweep_stop;f++)
+    {
+      cpufreq_step step;
+      step.mhz=0;
+      sweep_measure(step);
+      // keep steps sorted by clock
+      int g=freq_sweep.count;
+      while(g>0 && freq_sweep.steps[g-1].mhz>step.mhz)
+      {
+        freq_sweep.steps[g]=freq_sweep.steps[g-1];
+        g--;
+      }
+      freq_sweep.steps[g]=step;
+      freq_sweep.count++;
+    }
+  }
+
+  sweep_flag(freq_sweep);
+  freq_sweep.status=2;
+  return NULL;
+}
+
+///////////////////////////////////
+/*  Start sweep in background.   */
+/*  Not with the startup bench:  */
+/*  it uses the same buffers and */
+/*  its clock can't change       */
+///////////////////////////////////
+void cpufreq_sweep_start()
+{
+  if(sweep_running)
+    return;
+  if(!cpubench_done())
+  {
+    freq_sweep.status=0;
+    return;
+  }
+  sweep_stop=0;
+  freq_sweep.status=1;
+  if(pthread_create(&sweep_th,NULL,cpufreq_sweep_thd,NULL)==0)
+    sweep_running=1;
+  else
+    freq_sweep.status=0;
+}
+
+///////////////////////////////////
+/*  Wait for the sweep to end    */
+///////////////////////////////////
+void cpufreq_sweep_wait()
+{
+  if(!sweep_running)
+    return;
+  pthread_join(sweep_th,NULL);
+  sweep_running=0;
+}
+
+///////////////////////////////////
+/*  Stop sweep thread            */
+///////////////////////////////////
+void cpufreq_sweep_end()
+{
+  if(!sweep_running)
+    return;
+  sweep_stop=1;
+  pthread_join(sweep_th,NULL);
+  sweep_running=0;
+}
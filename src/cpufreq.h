@@ -0,0 +1,53 @@
+/*
+  RG350 Test
+  CPU frequency, read from cpufreq sysfs, and frequency sweep: runs a
+  benchmark kernel at every cpufreq step.
+
+  The sysfs folder can be changed with cpufreq_setroot(), the app sets
+  it from RG350TEST_CPUFREQ, so a fake folder with the same files can be
+  used when testing on a PC.
+*/
+
+#ifndef CPUFREQ_H
+#define CPUFREQ_H
+
+#define CPUFREQ_ROOT      "/sys/devices/system/cpu/cpu0/cpufreq"
+#define CPUFREQ_MAXSTEPS  24
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct cpufreq_step
+{
+  int mhz;          // requested clock, or clock chosen by the governor
+  int real_mhz;     // clock read after the benchmark
+  double alu;       // Mops/s of the alu kernel
+  double mem;       // MB/s of the memcpy kernel
+  int slow_cpu;     // alu throughput doesn't scale with clock (throttling)
+  int slow_mem;     // memory throughput stopped growing (memory bound)
+};
+
+struct cpufreq_sweep
+{
+  int status;       // 0=not run, 1=running, 2=done
+  int writable;     // 1=steps forced with scaling_min/max_freq, 0=governor steps
+  int count;
+  cpufreq_step steps[CPUFREQ_MAXSTEPS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern cpufreq_sweep freq_sweep;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void cpufreq_setroot(const char* path);
+int cpufreq_read(const char* file);
+int cpufreq_available(int* khz, int max);
+void cpufreq_sweep_start();
+void cpufreq_sweep_wait();
+void cpufreq_sweep_end();
+
+#endif
@@ -0,0 +1,91 @@
+/*
+  RG350 Test
+  Drawing primitives for surfaces in the screen pixel format. Surfaces
+  with another pixel size are ignored.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include "draw.h"
+
+///////////////////////////////////
+/*  Lock surface if needed       */
+///////////////////////////////////
+static int draw_lock(SDL_Surface* dst)
+{
+  if(!dst || dst->format->BytesPerPixel!=sizeof(screen_pixel))
+    return 0;
+  if(SDL_MUSTLOCK(dst) && SDL_LockSurface(dst)<0)
+    return 0;
+  return 1;
+}
+
+static void draw_unlock(SDL_Surface* dst)
+{
+  if(SDL_MUSTLOCK(dst))
+    SDL_UnlockSurface(dst);
+}
+
+///////////////////////////////////
+/*  Horizontal line              */
+///////////////////////////////////
+void draw_hline(SDL_Surface* dst, int x0, int x1, int y, Uint32 color)
+{
+  if(!draw_lock(dst))
+    return;
+  hline_t<screen_pixel>(dst,x0,x1,y,(screen_pixel)color);
+  draw_unlock(dst);
+}
+
+///////////////////////////////////
+/*  Vertical line                */
+///////////////////////////////////
+void draw_vline(SDL_Surface* dst, int x, int y0, int y1, Uint32 color)
+{
+  if(!draw_lock(dst))
+    return;
+  vline_t<screen_pixel>(dst,x,y0,y1,(screen_pixel)color);
+  draw_unlock(dst);
+}
+
+///////////////////////////////////
+/*  Line                         */
+///////////////////////////////////
+void draw_line(SDL_Surface* dst, int x0, int y0, int x1, int y1, Uint32 color)
+{
+  if(!draw_lock(dst))
+    return;
+  line_t<screen_pixel>(dst,x0,y0,x1,y1,(screen_pixel)color);
+  draw_unlock(dst);
+}
+
+///////////////////////////////////
+/*  Ellipse outline              */
+///////////////////////////////////
+void draw_ellipse(SDL_Surface* dst, int cx, int cy, int rx, int ry, Uint32 color)
+{
+  if(!draw_lock(dst))
+    return;
+  ellipse_t<screen_pixel>(dst,cx,cy,rx,ry,(screen_pixel)color);
+  draw_unlock(dst);
+}
+
+///////////////////////////////////
+/*  Circle outline               */
+///////////////////////////////////
+void draw_circle(SDL_Surface* dst, int cx, int cy, int r, Uint32 color)
+{
+  draw_ellipse(dst,cx,cy,r,r,color);
+}
+
+///////////////////////////////////
+/*  Rectangle outline            */
+///////////////////////////////////
+void draw_rect(SDL_Surface* dst, int x, int y, int w, int h, Uint32 color)
+{
+  if(!draw_lock(dst))
+    return;
+  rect_t<screen_pixel>(dst,x,y,w,h,(screen_pixel)color);
+  draw_unlock(dst);
+}
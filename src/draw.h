@@ -0,0 +1,242 @@
+/*
+  RG350 Test
+  Drawing primitives: lines, spans, ellipses and rectangles.
+
+  Templates are written for a pixel type, and the screen pixel type is
+  chosen at compile time with SCREEN_BPP (16=RGB565, 32=XRGB8888), so
+  the inner loops only store pixels. All primitives are clipped to the
+  clip rectangle of the surface.
+*/
+
+#ifndef DRAW_H
+#define DRAW_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#ifndef SCREEN_BPP
+#define SCREEN_BPP 16
+#endif
+
+///////////////////////////////////
+/*  Pixel formats                */
+///////////////////////////////////
+template<int BPP> struct pixel_format {};
+template<> struct pixel_format<16> { typedef Uint16 type; };
+template<> struct pixel_format<32> { typedef Uint32 type; };
+
+typedef pixel_format<SCREEN_BPP>::type screen_pixel;
+
+///////////////////////////////////
+/*  Address of a pixel           */
+///////////////////////////////////
+template<typename T> inline T* pixel_at(SDL_Surface* dst, int x, int y)
+{
+  return (T*)((Uint8*)dst->pixels+y*dst->pitch)+x;
+}
+
+///////////////////////////////////
+/*  Put a pixel, CLIP=false when */
+/*  the caller knows it's inside */
+///////////////////////////////////
+template<typename T, bool CLIP> inline void plot_t(SDL_Surface* dst, int x, int y, T color)
+{
+  if(CLIP)
+  {
+    const SDL_Rect& clip=dst->clip_rect;
+    if(x<clip.x || y<clip.y || x>=clip.x+clip.w || y>=clip.y+clip.h)
+      return;
+  }
+  *pixel_at<T>(dst,x,y)=color;
+}
+
+///////////////////////////////////
+/*  Horizontal span              */
+///////////////////////////////////
+template<typename T> void hline_t(SDL_Surface* dst, int x0, int x1, int y, T color)
+{
+  const SDL_Rect& clip=dst->clip_rect;
+  if(x0>x1)
+  {
+    int tmp=x0;
+    x0=x1;
+    x1=tmp;
+  }
+  if(y<clip.y || y>=clip.y+clip.h)
+    return;
+  if(x0<clip.x)
+    x0=clip.x;
+  if(x1>=clip.x+clip.w)
+    x1=clip.x+clip.w-1;
+
+  T* p=pixel_at<T>(dst,x0,y);
+  for(int n=x1-x0+1;n>0;n--)
+    *p++=color;
+}
+
+///////////////////////////////////
+/*  Vertical span                */
+///////////////////////////////////
+template<typename T> void vline_t(SDL_Surface* dst, int x, int y0, int y1, T color)
+{
+  const SDL_Rect& clip=dst->clip_rect;
+  if(y0>y1)
+  {
+    int tmp=y0;
+    y0=y1;
+    y1=tmp;
+  }
+  if(x<clip.x || x>=clip.x+clip.w)
+    return;
+  if(y0<clip.y)
+    y0=clip.y;
+  if(y1>=clip.y+clip.h)
+    y1=clip.y+clip.h-1;
+
+  Uint8* p=(Uint8*)pixel_at<T>(dst,x,y0);
+  for(int n=y1-y0+1;n>0;n--)
+  {
+    *(T*)p=color;
+    p+=dst->pitch;
+  }
+}
+
+///////////////////////////////////
+/*  Bresenham line               */
+///////////////////////////////////
+template<typename T, bool CLIP> void line_bresenham_t(SDL_Surface* dst, int x0, int y0, int x1, int y1, T color)
+{
+  int dx=x1>x0?x1-x0:x0-x1;
+  int dy=y1>y0?y0-y1:y1-y0;    // negative
+  int sx=x0<x1?1:-1;
+  int sy=y0<y1?1:-1;
+  int err=dx+dy;
+
+  while(1)
+  {
+    plot_t<T,CLIP>(dst,x0,y0,color);
+    if(x0==x1 && y0==y1)
+      break;
+    int e2=2*err;
+    if(e2>=dy)
+    {
+      err+=dy;
+      x0+=sx;
+    }
+    if(e2<=dx)
+    {
+      err+=dx;
+      y0+=sy;
+    }
+  }
+}
+
+template<typename T> void line_t(SDL_Surface* dst, int x0, int y0, int x1, int y1, T color)
+{
+  const SDL_Rect& clip=dst->clip_rect;
+  int left=clip.x,top=clip.y,right=clip.x+clip.w,bottom=clip.y+clip.h;
+
+  if(y0==y1)
+    hline_t<T>(dst,x0,x1,y0,color);
+  else if(x0==x1)
+    vline_t<T>(dst,x0,y0,y1,color);
+  else if(x0>=left && x1>=left && x0<right && x1<right && y0>=top && y1>=top && y0<bottom && y1<bottom)
+    line_bresenham_t<T,false>(dst,x0,y0,x1,y1,color);
+  else if(!((x0<left && x1<left) || (x0>=right && x1>=right) || (y0<top && y1<top) || (y0>=bottom && y1>=bottom)))
+    line_bresenham_t<T,true>(dst,x0,y0,x1,y1,color);
+}
+
+///////////////////////////////////
+/*  Midpoint ellipse outline     */
+///////////////////////////////////
+template<typename T, bool CLIP> inline void plot4_t(SDL_Surface* dst, int cx, int cy, int x, int y, T color)
+{
+  plot_t<T,CLIP>(dst,cx+x,cy+y,color);
+  plot_t<T,CLIP>(dst,cx-x,cy+y,color);
+  plot_t<T,CLIP>(dst,cx+x,cy-y,color);
+  plot_t<T,CLIP>(dst,cx-x,cy-y,color);
+}
+
+template<typename T, bool CLIP> void ellipse_midpoint_t(SDL_Surface* dst, int cx, int cy, int rx, int ry, T color)
+{
+  long rx2=(long)rx*rx;
+  long ry2=(long)ry*ry;
+  int x=0;
+  int y=ry;
+  long px=0;
+  long py=2*rx2*y;
+
+  // region 1, slope above -1
+  long p=ry2-rx2*ry+rx2/4;
+  while(px<py)
+  {
+    plot4_t<T,CLIP>(dst,cx,cy,x,y,color);
+    x++;
+    px+=2*ry2;
+    if(p<0)
+      p+=ry2+px;
+    else
+    {
+      y--;
+      py-=2*rx2;
+      p+=ry2+px-py;
+    }
+  }
+
+  // region 2, slope below -1
+  p=ry2*(2*x+1)*(2*x+1)/4+rx2*(long)(y-1)*(y-1)-rx2*ry2;
+  while(y>=0)
+  {
+    plot4_t<T,CLIP>(dst,cx,cy,x,y,color);
+    y--;
+    py-=2*rx2;
+    if(p>0)
+      p+=rx2-py;
+    else
+    {
+      x++;
+      px+=2*ry2;
+      p+=rx2-py+px;
+    }
+  }
+}
+
+template<typename T> void ellipse_t(SDL_Surface* dst, int cx, int cy, int rx, int ry, T color)
+{
+  const SDL_Rect& clip=dst->clip_rect;
+
+  if(rx<0 || ry<0)
+    return;
+  if(cx-rx>=clip.x && cy-ry>=clip.y && cx+rx<clip.x+clip.w && cy+ry<clip.y+clip.h)
+    ellipse_midpoint_t<T,false>(dst,cx,cy,rx,ry,color);
+  else
+    ellipse_midpoint_t<T,true>(dst,cx,cy,rx,ry,color);
+}
+
+///////////////////////////////////
+/*  Rectangle outline            */
+///////////////////////////////////
+template<typename T> void rect_t(SDL_Surface* dst, int x, int y, int w, int h, T color)
+{
+  if(w<=0 || h<=0)
+    return;
+  hline_t<T>(dst,x,x+w-1,y,color);
+  hline_t<T>(dst,x,x+w-1,y+h-1,color);
+  vline_t<T>(dst,x,y,y+h-1,color);
+  vline_t<T>(dst,x+w-1,y,y+h-1,color);
+}
+
+///////////////////////////////////
+/*  Function declarations        */
+/*  (screen pixel format)        */
+///////////////////////////////////
+void draw_hline(SDL_Surface* dst, int x0, int x1, int y, Uint32 color);
+void draw_vline(SDL_Surface* dst, int x, int y0, int y1, Uint32 color);
+void draw_line(SDL_Surface* dst, int x0, int y0, int x1, int y1, Uint32 color);
+void draw_ellipse(SDL_Surface* dst, int cx, int cy, int rx, int ry, Uint32 color);
+void draw_circle(SDL_Surface* dst, int cx, int cy, int r, Uint32 color);
+void draw_rect(SDL_Surface* dst, int x, int y, int w, int h, Uint32 color);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+  RG350 Test
+  Guided factory test: every input is asked in turn, then both sticks,
+  sound, rumble and the SD cards. Steps advance when the input is
+  detected or the time is over, every step is timed.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "timing.h"
+#include "synth.h"
+#include "rumble.h"
+#include "factory.h"
+
+#define FACTORY_BUTTONTIME   10000   // ms to press a button
+#define FACTORY_STICKTIME    15000   // ms to reach the four edges
+#define FACTORY_CONFIRMTIME  20000   // ms to answer if it sounds or rumbles
+#define FACTORY_STICKRANGE   24000   // axis value of an edge
+#define FACTORY_RUMBLEREPEAT 2000    // ms between pulse trains
+#define FACTORY_SDBYTES      (64*1024)
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+factory_test factory;
+const char* factory_names[FACTORY_STEPS]={
+  "UP","DOWN","LEFT","RIGHT","A","B","X","Y","L1","L2","R1","R2",
+  "SELECT","START","VOL-","VOL+","POWER","L3","R3",
+  "left stick","right stick","sound","rumble","SD cards"
+};
+
+///////////////////////////////////
+/*  Write, read back and remove  */
+/*  a file, 1 if ok              */
+///////////////////////////////////
+static int factory_sdfile(const char* dir)
+{
+  static unsigned char written[FACTORY_SDBYTES];
+  static unsigned char readback[FACTORY_SDBYTES];
+  char path[128];
+  int f;
+
+  for(f=0;f<FACTORY_SDBYTES;f++)
+    written[f]=(unsigned char)(f*7+(f>>8));
+  snprintf(path,sizeof(path),"%s/.rg350test.tmp",dir);
+  int fd=open(path,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  if(fd<0)
+    return 0;
+  int ok=write(fd,written,FACTORY_SDBYTES)==FACTORY_SDBYTES;
+  if(fsync(fd)<0)
+    ok=0;
+  close(fd);
+
+  fd=open(path,O_RDONLY);
+  if(fd<0)
+    ok=0;
+  else
+  {
+    if(read(fd,readback,FACTORY_SDBYTES)!=FACTORY_SDBYTES || memcmp(written,readback,FACTORY_SDBYTES)!=0)
+      ok=0;
+    close(fd);
+  }
+  unlink(path);
+  return ok;
+}
+
+///////////////////////////////////
+/*  Internal card must work, the */
+/*  external one only if it's in */
+///////////////////////////////////
+static int factory_sdcheck()
+{
+  struct stat info;
+  if(!factory_sdfile("/usr/local/home"))
+    return 0;
+  if(stat("/media/sdcard",&info)==0 && S_ISDIR(info.st_mode))
+  {
+    // empty mount point, no card
+    struct stat parent;
+    if(stat("/media",&parent)==0 && parent.st_dev==info.st_dev)
+      return 1;
+    return factory_sdfile("/media/sdcard");
+  }
+  return 1;
+}
+
+///////////////////////////////////
+/*  Start the step               */
+///////////////////////////////////
+static void factory_enter(factory_test& test, int step)
+{
+  test.step=step;
+  test.step_start=time_us();
+  if(step==FACTORY_STICK1 || step==FACTORY_STICK2)
+  {
+    for(int f=(step-FACTORY_STICK1)*2;f<(step-FACTORY_STICK1)*2+2;f++)
+      test.axis_min[f]=test.axis_max[f]=0;
+  }
+  else if(step==FACTORY_SOUND)
+    synth_play(SYNTH_SWEEP);
+  else if(step==FACTORY_RUMBLE)
+  {
+    test.rumble_time=test.step_start;
+    rumble_play(RUMBLE_PULSES);
+  }
+}
+
+///////////////////////////////////
+/*  Save the result and go to    */
+/*  the next step                */
+///////////////////////////////////
+static void factory_next(factory_test& test, int result)
+{
+  factory_step& current=test.steps[test.step];
+  current.result=result;
+  current.time_ms=(unsigned int)((time_us()-test.step_start)/1000);
+  if(result==FACTORY_PASS)
+    test.passed++;
+  if(test.step==FACTORY_SOUND)
+    synth_stop();
+
+  if(test.step+1<FACTORY_STEPS)
+  {
+    factory_enter(test,test.step+1);
+    return;
+  }
+  test.total_ms=(unsigned int)((time_us()-test.start)/1000);
+  test.status=2;
+}
+
+///////////////////////////////////
+/*  Time to finish a step, ms    */
+///////////////////////////////////
+unsigned int factory_timeout(int step)
+{
+  if(step<FACTORY_BUTTONS)
+    return FACTORY_BUTTONTIME;
+  if(step==FACTORY_STICK1 || step==FACTORY_STICK2)
+    return FACTORY_STICKTIME;
+  return FACTORY_CONFIRMTIME;
+}
+
+///////////////////////////////////
+/*  Start the test               */
+///////////////////////////////////
+void factory_start(factory_test& test)
+{
+  memset(&test,0,sizeof(test));
+  test.status=1;
+  test.start=time_us();
+  // buttons held when the test starts aren't detected until pressed again
+  test.inputs=~0U;
+  factory_enter(test,0);
+}
+
+///////////////////////////////////
+/*  Called every frame with the  */
+/*  pressed inputs, one bit each */
+/*  button, and the four axes    */
+///////////////////////////////////
+void factory_update(factory_test& test, Uint32 inputs, const int* axes)
+{
+  if(test.status!=1)
+    return;
+
+  // only the buttons pressed in this frame
+  Uint32 pressed=inputs & ~test.inputs;
+  test.inputs=inputs;
+  unsigned int elapsed=(unsigned int)((time_us()-test.step_start)/1000);
+  int step=test.step;
+  int f;
+
+  if(step<FACTORY_BUTTONS)
+  {
+    if(pressed & (1<<step))
+      factory_next(test,FACTORY_PASS);
+    else if(pressed)
+      test.wrong++;
+    else if(elapsed>=FACTORY_BUTTONTIME)
+      factory_next(test,FACTORY_TIMEOUT);
+    return;
+  }
+
+  switch(step)
+  {
+    case FACTORY_STICK1:
+    case FACTORY_STICK2:
+    {
+      int first=(step-FACTORY_STICK1)*2;
+      int edges=1;
+      for(f=first;f<first+2;f++)
+      {
+        if(axes[f]<test.axis_min[f])
+          test.axis_min[f]=axes[f];
+        if(axes[f]>test.axis_max[f])
+          test.axis_max[f]=axes[f];
+        if(test.axis_min[f]>-FACTORY_STICKRANGE || test.axis_max[f]<FACTORY_STICKRANGE)
+          edges=0;
+      }
+      if(edges)
+        factory_next(test,FACTORY_PASS);
+      else if(elapsed>=FACTORY_STICKTIME)
+        factory_next(test,FACTORY_TIMEOUT);
+      break;
+    }
+    case FACTORY_SOUND:
+    case FACTORY_RUMBLE:
+      // the operator answers: A works, B doesn't
+      if(pressed & (1<<FACTORY_A))
+        factory_next(test,FACTORY_PASS);
+      else if(pressed & (1<<FACTORY_B))
+        factory_next(test,FACTORY_FAIL);
+      else if(elapsed>=FACTORY_CONFIRMTIME)
+        factory_next(test,FACTORY_TIMEOUT);
+      else if(step==FACTORY_RUMBLE && time_us()-test.rumble_time>=FACTORY_RUMBLEREPEAT*1000ULL)
+      {
+        test.rumble_time=time_us();
+        rumble_play(RUMBLE_PULSES);
+      }
+      break;
+    case FACTORY_SD:
+      factory_next(test,factory_sdcheck()?FACTORY_PASS:FACTORY_FAIL);
+      break;
+  }
+}
+
+///////////////////////////////////
+/*  Cancel the test              */
+///////////////////////////////////
+void factory_stop(factory_test& test)
+{
+  if(test.status!=1)
+    return;
+  if(test.step==FACTORY_SOUND)
+    synth_stop();
+  test.status=0;
+}
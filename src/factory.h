@@ -0,0 +1,89 @@
+/*
+  RG350 Test
+  Guided factory test: every input is asked in turn, then both sticks,
+  sound, rumble and the SD cards. Steps advance when the input is
+  detected or the time is over, every step is timed.
+*/
+
+#ifndef FACTORY_H
+#define FACTORY_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+// buttons, also the bits of the inputs
+#define FACTORY_UP        0
+#define FACTORY_DOWN      1
+#define FACTORY_LEFT      2
+#define FACTORY_RIGHT     3
+#define FACTORY_A         4
+#define FACTORY_B         5
+#define FACTORY_X         6
+#define FACTORY_Y         7
+#define FACTORY_L1        8
+#define FACTORY_L2        9
+#define FACTORY_R1        10
+#define FACTORY_R2        11
+#define FACTORY_SELECT    12
+#define FACTORY_START     13
+#define FACTORY_VOLDOWN   14
+#define FACTORY_VOLUP     15
+#define FACTORY_POWER     16
+#define FACTORY_L3        17
+#define FACTORY_R3        18
+#define FACTORY_BUTTONS   19
+// other steps
+#define FACTORY_STICK1    19
+#define FACTORY_STICK2    20
+#define FACTORY_SOUND     21
+#define FACTORY_RUMBLE    22
+#define FACTORY_SD        23
+#define FACTORY_STEPS     24
+
+#define FACTORY_NOTRUN    0
+#define FACTORY_PASS      1
+#define FACTORY_TIMEOUT   2
+#define FACTORY_FAIL      3   // operator said it doesn't work, or SD error
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct factory_step
+{
+  int result;
+  unsigned int time_ms;
+};
+
+struct factory_test
+{
+  int status;             // 0=not run, 1=running, 2=done
+  int step;
+  unsigned long long start;
+  unsigned long long step_start;
+  unsigned long long rumble_time;   // last pulse train of the rumble step
+  Uint32 inputs;          // pressed in the last update
+  unsigned int wrong;     // other buttons pressed while waiting
+  int axis_min[4];        // stick axes seen in the stick steps
+  int axis_max[4];
+  unsigned int total_ms;
+  int passed;
+  factory_step steps[FACTORY_STEPS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern factory_test factory;
+extern const char* factory_names[FACTORY_STEPS];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void factory_start(factory_test& test);
+void factory_update(factory_test& test, Uint32 inputs, const int* axes);
+void factory_stop(factory_test& test);
+unsigned int factory_timeout(int step);
+
+#endif
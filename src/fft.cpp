@@ -0,0 +1,103 @@
+/*
+  RG350 Test
+  Fixed-point radix-2 FFT of 256 samples with a Hann window, power of
+  128 bins. Integer only, with a scale of 1/2 every stage so it can't
+  overflow.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <math.h>
+#include "fft.h"
+
+#define FFT_FULLSCALE  26   // log2 of the power of a full scale sine in its bin
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+static Sint16 fft_window[FFT_SIZE];     // Hann, 1.15
+static Sint16 fft_cos[FFT_SIZE/2];      // twiddles, 1.15
+static Sint16 fft_sin[FFT_SIZE/2];
+static Uint8 fft_reverse[FFT_SIZE];
+
+///////////////////////////////////
+/*  Build the tables             */
+///////////////////////////////////
+void fft_init()
+{
+  for(int f=0;f<FFT_SIZE;f++)
+  {
+    fft_window[f]=(Sint16)((0.5-0.5*cos(2*M_PI*f/FFT_SIZE))*32767);
+    int reverse=0;
+    for(int b=0;b<FFT_BITS;b++)
+      if(f & (1<<b))
+        reverse|=1<<(FFT_BITS-1-b);
+    fft_reverse[f]=(Uint8)reverse;
+  }
+  for(int f=0;f<FFT_SIZE/2;f++)
+  {
+    fft_cos[f]=(Sint16)(cos(2*M_PI*f/FFT_SIZE)*32767);
+    fft_sin[f]=(Sint16)(sin(2*M_PI*f/FFT_SIZE)*32767);
+  }
+}
+
+///////////////////////////////////
+/*  Power of every bin, the      */
+/*  result is divided by the     */
+/*  size                         */
+///////////////////////////////////
+void fft_power(const Sint16* in, Uint32* power)
+{
+  Sint32 re[FFT_SIZE];
+  Sint32 im[FFT_SIZE];
+  int f;
+
+  for(f=0;f<FFT_SIZE;f++)
+  {
+    re[fft_reverse[f]]=(in[f]*fft_window[f])>>15;
+    im[fft_reverse[f]]=0;
+  }
+
+  for(int size=2;size<=FFT_SIZE;size<<=1)
+  {
+    int half=size/2;
+    int step=FFT_SIZE/size;
+    for(int start=0;start<FFT_SIZE;start+=size)
+    {
+      for(int k=0;k<half;k++)
+      {
+        // b times e^(-i*2*pi*k/size)
+        Sint32 c=fft_cos[k*step];
+        Sint32 s=fft_sin[k*step];
+        int a=start+k;
+        int b=a+half;
+        Sint32 tr=(re[b]*c+im[b]*s)>>15;
+        Sint32 ti=(im[b]*c-re[b]*s)>>15;
+        re[b]=(re[a]-tr)>>1;
+        im[b]=(im[a]-ti)>>1;
+        re[a]=(re[a]+tr)>>1;
+        im[a]=(im[a]+ti)>>1;
+      }
+    }
+  }
+
+  for(f=0;f<FFT_BINS;f++)
+    power[f]=(Uint32)(re[f]*re[f])+(Uint32)(im[f]*im[f]);
+}
+
+///////////////////////////////////
+/*  dB of a bin against a full   */
+/*  scale sine, with an integer  */
+/*  log2                         */
+///////////////////////////////////
+int fft_db(Uint32 power)
+{
+  if(power==0)
+    return -120;
+  int exponent=31-__builtin_clz(power);
+  // 8 bits of mantissa, linear between powers of 2
+  int fraction=exponent>=8?(power>>(exponent-8))&0xFF:(power<<(8-exponent))&0xFF;
+  int log2_256=(exponent-FFT_FULLSCALE)*256+fraction;
+  return log2_256*301/25600;  // 10*log10(2)=3.01
+}
@@ -0,0 +1,27 @@
+/*
+  RG350 Test
+  Fixed-point radix-2 FFT of 256 samples with a Hann window, power of
+  128 bins. Integer only, with a scale of 1/2 every stage so it can't
+  overflow.
+*/
+
+#ifndef FFT_H
+#define FFT_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define FFT_BITS   8
+#define FFT_SIZE   (1<<FFT_BITS)
+#define FFT_BINS   (FFT_SIZE/2)
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void fft_init();
+void fft_power(const Sint16* in, Uint32* power);
+int fft_db(Uint32 power);
+
+#endif
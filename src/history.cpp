@@ -0,0 +1,498 @@
+/*
+  RG350 Test
+  History of results: a binary file where every session appends one
+  fixed size record. Records of a unit are chained backwards and a small
+  index keeps the last record of every unit, so loading a unit reads
+  only its own records.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "timing.h"
+#include "factory.h"
+#include "cpubench.h"
+#include "history.h"
+
+#define HISTORY_MAGIC       0x31484752   // "RGH1"
+#define HISTORY_INDEXMAGIC  0x31494752   // "RGI1"
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct history_header
+{
+  Uint32 magic;
+  Uint32 records;         // records in the history when it was written
+  Uint32 devices;
+  Uint32 check;
+};
+
+struct history_entry
+{
+  unsigned long long device;
+  Sint32 last;            // newest record of the unit
+  Uint32 runs;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+history_state history;
+
+static history_entry* history_entries=NULL;
+static int history_capacity=0;
+static int history_devices=0;
+// record of this session, saved again in place
+static Sint32 history_session=-1;
+static char history_sessiondir[128]="";
+
+///////////////////////////////////
+/*  FNV-1a hashes                */
+///////////////////////////////////
+static Uint32 history_check(const void* data, int size)
+{
+  const unsigned char* bytes=(const unsigned char*)data;
+  Uint32 hash=2166136261U;
+  for(int f=0;f<size;f++)
+    hash=(hash^bytes[f])*16777619U;
+  return hash;
+}
+
+static unsigned long long history_hash(const char* text)
+{
+  unsigned long long hash=14695981039346656037ULL;
+  for(;*text;text++)
+    hash=(hash^(unsigned char)*text)*1099511628211ULL;
+  return hash;
+}
+
+static int history_valid(const history_record& record)
+{
+  return record.magic==HISTORY_MAGIC && record.check==history_check(&record,sizeof(record)-sizeof(record.check));
+}
+
+///////////////////////////////////
+/*  Room for some units in the   */
+/*  index, 1 if ok               */
+///////////////////////////////////
+static int history_reserve(int count)
+{
+  if(count<=history_capacity)
+    return 1;
+  int capacity=history_capacity?history_capacity:HISTORY_DEVICES;
+  while(capacity<count)
+    capacity*=2;
+  history_entry* entries=(history_entry*)realloc(history_entries,capacity*sizeof(history_entry));
+  if(!entries)
+  {
+    snprintf(history.error,sizeof(history.error),"No memory for the index.");
+    return 0;
+  }
+  history_entries=entries;
+  history_capacity=capacity;
+  return 1;
+}
+
+///////////////////////////////////
+/*  First line of a file         */
+///////////////////////////////////
+static int history_readline(const char* path, char* text, int size)
+{
+  FILE* fd=fopen(path,"r");
+  if(!fd)
+    return 0;
+  int ok=fgets(text,size,fd)!=NULL;
+  fclose(fd);
+  if(!ok)
+    return 0;
+  text[strcspn(text,"\r\n")]=0;
+  return text[0]!=0;
+}
+
+///////////////////////////////////
+/*  Device id: cpu serial, mac   */
+/*  or one made and saved in the */
+/*  internal card                */
+///////////////////////////////////
+static void history_readid()
+{
+  char line[128];
+  FILE* fd=fopen("/proc/cpuinfo","r");
+  if(fd)
+  {
+    while(fgets(line,sizeof(line),fd))
+    {
+      char serial[40];
+      if(sscanf(line,"Serial : %39s",serial)==1 && strspn(serial,"0")!=strlen(serial))
+      {
+        strcpy(history.id,serial);
+        history.source="cpu serial";
+        fclose(fd);
+        return;
+      }
+    }
+    fclose(fd);
+  }
+
+  // usb0 is left out, the gadget driver makes a new address every boot
+  const char* macs[2]={"/sys/class/net/wlan0/address","/sys/class/net/eth0/address"};
+  for(int f=0;f<2;f++)
+  {
+    if(history_readline(macs[f],line,sizeof(line)) && strcmp(line,"00:00:00:00:00:00")!=0)
+    {
+      snprintf(history.id,sizeof(history.id),"%.39s",line);
+      history.source="mac";
+      return;
+    }
+  }
+
+  history.source="generated";
+  if(history_readline(HISTORY_IDFILE,line,sizeof(line)))
+  {
+    snprintf(history.id,sizeof(history.id),"%.39s",line);
+    return;
+  }
+  unsigned long long random=0;
+  int rnd=open("/dev/urandom",O_RDONLY);
+  if(rnd>=0)
+  {
+    if(read(rnd,&random,sizeof(random))!=sizeof(random))
+      random=0;
+    close(rnd);
+  }
+  if(!random)
+    random=time_us()^((unsigned long long)getpid()<<32);
+  snprintf(history.id,sizeof(history.id),"%016llx",random);
+  int out=open(HISTORY_IDFILE,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  if(out>=0)
+  {
+    snprintf(line,sizeof(line),"%s\n",history.id);
+    if(write(out,line,strlen(line))==(int)strlen(line))
+      fsync(out);
+    close(out);
+  }
+}
+
+///////////////////////////////////
+/*  Folder of the files, the     */
+/*  external card if it's in     */
+///////////////////////////////////
+static const char* history_dir()
+{
+  if(report_mounted(report_cards[1]))
+    return report_cards[1];
+  return report_cards[0];
+}
+
+///////////////////////////////////
+/*  Whole records in the file, a */
+/*  cut record at the end is     */
+/*  ignored                      */
+///////////////////////////////////
+static int history_records(const char* dir)
+{
+  char path[160];
+  struct stat info;
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_FILE);
+  if(stat(path,&info)<0)
+    return 0;
+  return (int)(info.st_size/sizeof(history_record));
+}
+
+///////////////////////////////////
+/*  Index, 1 if it matches the   */
+/*  history                      */
+///////////////////////////////////
+static int history_readindex(const char* dir, int records)
+{
+  char path[160];
+  history_header header;
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_INDEX);
+  history_devices=0;
+  int fd=open(path,O_RDONLY);
+  if(fd<0)
+    return 0;
+  int ok=read(fd,&header,sizeof(header))==sizeof(header) && header.magic==HISTORY_INDEXMAGIC &&
+    header.records==(Uint32)records && header.devices<=HISTORY_MAXDEVICES && history_reserve(header.devices);
+  if(ok)
+  {
+    int size=header.devices*sizeof(history_entry);
+    ok=read(fd,history_entries,size)==size && header.check==history_check(history_entries,size);
+  }
+  close(fd);
+  if(ok)
+    history_devices=header.devices;
+  return ok;
+}
+
+///////////////////////////////////
+/*  Rebuild the index reading    */
+/*  the whole history, only when */
+/*  it was lost or is old        */
+///////////////////////////////////
+static void history_rebuild(const char* dir, int records)
+{
+  char path[160];
+  history_record chunk[64];
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_FILE);
+  history_devices=0;
+  FILE* fd=fopen(path,"rb");
+  if(!fd)
+    return;
+  int number=0;
+  while(number<records)
+  {
+    int count=fread(chunk,sizeof(history_record),64,fd);
+    if(count<=0)
+      break;
+    for(int f=0;f<count && number<records;f++,number++)
+    {
+      if(!history_valid(chunk[f]))
+        continue;
+      int e;
+      for(e=0;e<history_devices && history_entries[e].device!=chunk[f].device;e++);
+      if(e==history_devices)
+      {
+        if(!history_reserve(history_devices+1))
+          continue;
+        history_entries[e].device=chunk[f].device;
+        history_entries[e].runs=0;
+        history_devices++;
+      }
+      history_entries[e].last=number;
+      history_entries[e].runs++;
+    }
+  }
+  fclose(fd);
+}
+
+///////////////////////////////////
+/*  Write the index to a         */
+/*  temporary file and rename it */
+///////////////////////////////////
+static int history_writeindex(const char* dir, int records)
+{
+  char path[160];
+  char temp[168];
+  history_header header;
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_INDEX);
+  snprintf(temp,sizeof(temp),"%s.tmp",path);
+  int size=history_devices*sizeof(history_entry);
+  header.magic=HISTORY_INDEXMAGIC;
+  header.records=records;
+  header.devices=history_devices;
+  header.check=history_check(history_entries,size);
+
+  int out=open(temp,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  if(out<0)
+    return 0;
+  int ok=write(out,&header,sizeof(header))==sizeof(header) && write(out,history_entries,size)==size;
+  if(fsync(out)<0)
+    ok=0;
+  if(close(out)<0)
+    ok=0;
+  if(!ok || rename(temp,path)<0)
+  {
+    unlink(temp);
+    return 0;
+  }
+  int folder=open(dir,O_RDONLY);
+  if(folder>=0)
+  {
+    fsync(folder);
+    close(folder);
+  }
+  return 1;
+}
+
+///////////////////////////////////
+/*  Index matching the history   */
+///////////////////////////////////
+static void history_index(const char* dir, int records)
+{
+  if(history_readindex(dir,records))
+    return;
+  history_rebuild(dir,records);
+  history_writeindex(dir,records);
+}
+
+///////////////////////////////////
+/*  Entry of the unit, -1 if     */
+/*  it has no records            */
+///////////////////////////////////
+static int history_find(unsigned long long device)
+{
+  for(int e=0;e<history_devices;e++)
+    if(history_entries[e].device==device)
+      return e;
+  return -1;
+}
+
+///////////////////////////////////
+/*  Load the last runs of the    */
+/*  unit following the chain     */
+///////////////////////////////////
+static void history_load(const char* dir)
+{
+  char path[160];
+  snprintf(history.path,sizeof(history.path),"%s",dir);
+  history.runs=0;
+  history.kept=0;
+  int records=history_records(dir);
+  history_index(dir,records);
+  int e=history_find(history.device);
+  if(e<0)
+    return;
+  history.runs=history_entries[e].runs;
+
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_FILE);
+  int fd=open(path,O_RDONLY);
+  if(fd<0)
+    return;
+  Sint32 number=history_entries[e].last;
+  while(number>=0 && number<records && history.kept<HISTORY_KEEP)
+  {
+    history_record& record=history.last[history.kept];
+    if(pread(fd,&record,sizeof(record),(off_t)number*sizeof(record))!=sizeof(record))
+      break;
+    // chains only go back
+    if(!history_valid(record) || record.device!=history.device || record.prev>=number)
+      break;
+    history.kept++;
+    number=record.prev;
+  }
+  close(fd);
+}
+
+///////////////////////////////////
+/*  Read the device id and load  */
+/*  its history                  */
+///////////////////////////////////
+void history_init()
+{
+  memset(&history,0,sizeof(history));
+  history_readid();
+  history.device=history_hash(history.id);
+  history_load(history_dir());
+}
+
+///////////////////////////////////
+/*  Append the results of the    */
+/*  last report, 1 if ok         */
+///////////////////////////////////
+int history_save(const report_info& info)
+{
+  char path[160];
+  history_record record;
+  int f;
+
+  memset(&record,0,sizeof(record));
+  record.device=history.device;
+  record.magic=HISTORY_MAGIC;
+  record.time=(Uint32)time(NULL);
+  record.battery_mv=report.microvolts/1000;
+  record.battery_level=info.battery_level;
+  record.charging=info.charging;
+  record.cpu_mhz=info.cpu_mhz;
+  record.cpu_score=bench_score;
+  for(f=0;f<2;f++)
+  {
+    record.sd_write[f]=(Uint16)(report.write_mbs[f]*100<65535?report.write_mbs[f]*100:65535);
+    record.sd_read[f]=(Uint16)(report.read_mbs[f]*100<65535?report.read_mbs[f]*100:65535);
+  }
+  for(f=0;f<4;f++)
+    record.stick_noise[f]=report_noise(f)>0?report_noise(f):0;
+  record.session_s=(Uint32)((time_us()-report.start)/1000000);
+  record.factory_passed=factory.status==2?factory.passed:-1;
+
+  const char* dir=history_dir();
+  snprintf(path,sizeof(path),"%s/%s",dir,HISTORY_FILE);
+  history.error[0]=0;
+  int fd=open(path,O_RDWR | O_CREAT,0644);
+  if(fd<0)
+  {
+    snprintf(history.error,sizeof(history.error),"Can't open the history.");
+    return 0;
+  }
+  // a record cut by a power loss is overwritten
+  int records=history_records(dir);
+  if(ftruncate(fd,(off_t)records*sizeof(record))<0)
+  {
+    close(fd);
+    snprintf(history.error,sizeof(history.error),"Can't write the history.");
+    return 0;
+  }
+  history_index(dir,records);
+  int e=history_find(history.device);
+
+  // saved before in this session: the same record is written again,
+  // so a session is one run and the previous run is another session
+  if(history_session>=0 && history_session<records && strcmp(history_sessiondir,dir)==0)
+  {
+    history_record saved;
+    if(pread(fd,&saved,sizeof(saved),(off_t)history_session*sizeof(saved))==sizeof(saved) &&
+      history_valid(saved) && saved.device==history.device)
+    {
+      record.prev=saved.prev;
+      record.check=history_check(&record,sizeof(record)-sizeof(record.check));
+      int ok=pwrite(fd,&record,sizeof(record),(off_t)history_session*sizeof(record))==sizeof(record);
+      if(fsync(fd)<0)
+        ok=0;
+      close(fd);
+      if(!ok)
+        snprintf(history.error,sizeof(history.error),"Can't write the history.");
+      history_load(dir);
+      return ok;
+    }
+  }
+
+  record.prev=e<0?-1:history_entries[e].last;
+  record.check=history_check(&record,sizeof(record)-sizeof(record.check));
+  int ok=pwrite(fd,&record,sizeof(record),(off_t)records*sizeof(record))==sizeof(record);
+  if(fsync(fd)<0)
+    ok=0;
+  close(fd);
+  if(!ok)
+  {
+    snprintf(history.error,sizeof(history.error),"Can't write the history.");
+    return 0;
+  }
+  history_session=records;
+  snprintf(history_sessiondir,sizeof(history_sessiondir),"%s",dir);
+
+  // new unit in the index
+  if(e<0 && history_reserve(history_devices+1))
+  {
+    e=history_devices++;
+    history_entries[e].device=history.device;
+    history_entries[e].runs=0;
+  }
+  if(e>=0)
+  {
+    history_entries[e].last=records;
+    history_entries[e].runs++;
+  }
+  if(!history_writeindex(dir,records+1))
+    snprintf(history.error,sizeof(history.error),"Can't write the index.");
+  history_load(dir);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Free the index               */
+///////////////////////////////////
+void history_end()
+{
+  free(history_entries);
+  history_entries=NULL;
+  history_capacity=0;
+  history_devices=0;
+}
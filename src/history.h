@@ -0,0 +1,73 @@
+/*
+  RG350 Test
+  History of results: a binary file where every session appends one
+  fixed size record. Records of a unit are chained backwards and a small
+  index keeps the last record of every unit, so loading a unit reads
+  only its own records.
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+#include "report.h"
+
+#define HISTORY_FILE     "rg350test_history.bin"
+#define HISTORY_INDEX    "rg350test_history.idx"
+#define HISTORY_IDFILE   "/usr/local/home/.rg350test_id"
+#define HISTORY_KEEP     8       // last runs of the unit loaded
+#define HISTORY_DEVICES  1024    // units in the index at first, it grows
+#define HISTORY_MAXDEVICES 1048576   // more in an index file is a broken file
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+// 64 bytes on disk
+struct history_record
+{
+  unsigned long long device;    // hash of the device id
+  Uint32 magic;
+  Uint32 time;                  // seconds since 1970
+  Sint32 prev;                  // record of the previous run of the unit, -1 first run
+  Sint32 battery_mv;
+  Sint16 battery_level;         // %
+  Sint16 charging;
+  Sint32 cpu_mhz;
+  Sint32 cpu_score;             // 0 if the benchmark didn't end
+  Uint16 sd_write[2];           // MB/s * 100, internal and external card
+  Uint16 sd_read[2];
+  Uint16 stick_noise[4];        // peak to peak at rest
+  Uint32 session_s;
+  Sint16 factory_passed;        // -1 if not run
+  Sint16 reserved;
+  Uint32 check;                 // of the bytes above
+};
+
+struct history_state
+{
+  char id[40];                  // device id as read
+  const char* source;           // where it was read
+  unsigned long long device;
+  char path[128];               // folder of the files, empty if not loaded
+  int runs;                     // records of the unit
+  int kept;
+  history_record last[HISTORY_KEEP];   // newest first
+  char error[48];               // last save or index error, empty if none
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern history_state history;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void history_init();
+int history_save(const report_info& info);
+void history_end();
+
+#endif
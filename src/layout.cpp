@@ -0,0 +1,286 @@
+/*
+  RG350 Test
+  Layout of the app in any video mode: positions are 320x240 and they
+  are scaled to the mode with the table of known panels. Sprites are
+  scaled once, when the mode is set, and kept in a cache.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <math.h>
+#include "draw.h"
+#include "sprite.h"
+#include "layout.h"
+
+#define LAYOUT_SPRITES  128   // sprites in the cache
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+ui_layout layout={LAYOUT_WIDTH,LAYOUT_HEIGHT,1,1,0,0,LAYOUT_NEAREST};
+
+// known panels: RG350 and RG280V, RG280M, RG350M
+static const ui_layout layout_modes[]={
+  {320,240,1,1,0,0,LAYOUT_NEAREST},
+  {480,320,4,3,0,0,LAYOUT_SMOOTH},
+  {640,480,2,1,0,0,LAYOUT_NEAREST}
+};
+#define LAYOUT_MODES  (int)(sizeof(layout_modes)/sizeof(layout_modes[0]))
+
+static SDL_Surface* layout_sources[LAYOUT_SPRITES];
+static SDL_Surface* layout_scaled[LAYOUT_SPRITES];
+static int layout_count=0;
+
+///////////////////////////////////
+/*  Read and write a pixel of a  */
+/*  16 or 32 bpp surface         */
+///////////////////////////////////
+static Uint32 layout_getpixel(SDL_Surface* src, int x, int y)
+{
+  Uint8* row=(Uint8*)src->pixels+y*src->pitch;
+  if(src->format->BytesPerPixel==2)
+    return ((Uint16*)row)[x];
+  return ((Uint32*)row)[x];
+}
+
+static void layout_putpixel(SDL_Surface* dst, int x, int y, Uint32 color)
+{
+  Uint8* row=(Uint8*)dst->pixels+y*dst->pitch;
+  if(dst->format->BytesPerPixel==2)
+    ((Uint16*)row)[x]=(Uint16)color;
+  else
+    ((Uint32*)row)[x]=color;
+}
+
+///////////////////////////////////
+/*  Pixel between four source    */
+/*  pixels, transparent pixels   */
+/*  aren't mixed                 */
+///////////////////////////////////
+static Uint32 layout_smoothpixel(SDL_Surface* src, double fx, double fy, int keyed, Uint32 key)
+{
+  int x0=(int)floor(fx);
+  int y0=(int)floor(fy);
+  double wx=fx-x0;
+  double wy=fy-y0;
+  double r=0,g=0,b=0,weight=0;
+
+  for(int f=0;f<4;f++)
+  {
+    int x=x0+(f&1);
+    int y=y0+(f>>1);
+    if(x<0)
+      x=0;
+    if(y<0)
+      y=0;
+    if(x>=src->w)
+      x=src->w-1;
+    if(y>=src->h)
+      y=src->h-1;
+    Uint32 pixel=layout_getpixel(src,x,y);
+    if(keyed && pixel==key)
+      continue;
+    double w=((f&1)?wx:1-wx)*((f>>1)?wy:1-wy);
+    Uint8 pr,pg,pb;
+    SDL_GetRGB(pixel,src->format,&pr,&pg,&pb);
+    r+=pr*w;
+    g+=pg*w;
+    b+=pb*w;
+    weight+=w;
+  }
+  if(weight<=0)
+    return key;
+  return SDL_MapRGB(src->format,(Uint8)(r/weight+0.5),(Uint8)(g/weight+0.5),(Uint8)(b/weight+0.5));
+}
+
+///////////////////////////////////
+/*  Scaled copy of a sprite      */
+///////////////////////////////////
+static SDL_Surface* layout_scale(SDL_Surface* src)
+{
+  SDL_PixelFormat* format=src->format;
+  if(format->BytesPerPixel!=2 && format->BytesPerPixel!=4)
+    return NULL;
+  int w=layout_len(src->w);
+  int h=layout_len(src->h);
+  if(w<1)
+    w=1;
+  if(h<1)
+    h=1;
+  SDL_Surface* dst=SDL_CreateRGBSurface(SDL_SWSURFACE,w,h,format->BitsPerPixel,format->Rmask,format->Gmask,format->Bmask,format->Amask);
+  if(!dst)
+    return NULL;
+
+  int keyed=(src->flags & SDL_SRCCOLORKEY)!=0;
+  Uint32 key=format->colorkey;
+  if(SDL_MUSTLOCK(src) && SDL_LockSurface(src)<0)
+  {
+    SDL_FreeSurface(dst);
+    return NULL;
+  }
+  for(int y=0;y<h;y++)
+  {
+    for(int x=0;x<w;x++)
+    {
+      // nearest pixel decides the shape, so edges don't mix with the colorkey
+      int sx=x*layout.den/layout.num;
+      int sy=y*layout.den/layout.num;
+      Uint32 pixel=layout_getpixel(src,sx,sy);
+      if(layout.filter==LAYOUT_SMOOTH && !(keyed && pixel==key))
+        pixel=layout_smoothpixel(src,(x+0.5)*layout.den/layout.num-0.5,(y+0.5)*layout.den/layout.num-0.5,keyed,key);
+      layout_putpixel(dst,x,y,pixel);
+    }
+  }
+  if(SDL_MUSTLOCK(src))
+    SDL_UnlockSurface(src);
+
+  if(keyed)
+    SDL_SetColorKey(dst,SDL_SRCCOLORKEY,key);
+  sprite_register(dst);
+  return dst;
+}
+
+///////////////////////////////////
+/*  Free scaled sprites          */
+///////////////////////////////////
+static void layout_freecache()
+{
+  for(int f=0;f<layout_count;f++)
+  {
+    if(!layout_scaled[f])
+      continue;
+    sprite_unregister(layout_scaled[f]);
+    SDL_FreeSurface(layout_scaled[f]);
+    layout_scaled[f]=NULL;
+  }
+}
+
+///////////////////////////////////
+/*  Layout for a video mode,     */
+/*  sprites are scaled again if  */
+/*  the scale changes            */
+///////////////////////////////////
+void layout_set(int w, int h)
+{
+  ui_layout mode={w,h,1,1,0,0,LAYOUT_NEAREST};
+  int known=0;
+  int f;
+
+  for(f=0;f<LAYOUT_MODES;f++)
+  {
+    if(layout_modes[f].w==w && layout_modes[f].h==h)
+    {
+      mode=layout_modes[f];
+      known=1;
+    }
+  }
+  if(!known)
+  {
+    // unknown mode, biggest integer scale
+    mode.num=w/LAYOUT_WIDTH<h/LAYOUT_HEIGHT?w/LAYOUT_WIDTH:h/LAYOUT_HEIGHT;
+    if(mode.num<1)
+      mode.num=1;
+  }
+  mode.x=(w-LAYOUT_WIDTH*mode.num/mode.den)/2;
+  mode.y=(h-LAYOUT_HEIGHT*mode.num/mode.den)/2;
+
+  int changed=mode.num*layout.den!=layout.num*mode.den || mode.filter!=layout.filter;
+  layout=mode;
+  if(!changed)
+    return;
+  layout_freecache();
+  if(layout.num==layout.den)
+    return;
+  for(f=0;f<layout_count;f++)
+    layout_scaled[f]=layout_scale(layout_sources[f]);
+}
+
+///////////////////////////////////
+/*  Add a sprite to the cache    */
+///////////////////////////////////
+void layout_register(SDL_Surface* src)
+{
+  if(!src || layout_count>=LAYOUT_SPRITES)
+    return;
+  layout_sources[layout_count]=src;
+  layout_scaled[layout_count]=(layout.num!=layout.den)?layout_scale(src):NULL;
+  layout_count++;
+}
+
+///////////////////////////////////
+/*  Sprite to draw in this mode  */
+///////////////////////////////////
+SDL_Surface* layout_sprite(SDL_Surface* src)
+{
+  if(layout.num==layout.den)
+    return src;
+  for(int f=0;f<layout_count;f++)
+    if(layout_sources[f]==src)
+      return layout_scaled[f]?layout_scaled[f]:src;
+  return src;
+}
+
+///////////////////////////////////
+/*  Free the cache               */
+///////////////////////////////////
+void layout_end()
+{
+  layout_freecache();
+  layout_count=0;
+}
+
+///////////////////////////////////
+/*  Fill a rectangle             */
+///////////////////////////////////
+void layout_fill(SDL_Surface* dst, SDL_Rect* rect, Uint32 color)
+{
+  SDL_Rect scaled;
+  scaled.x=layout_x(rect->x);
+  scaled.y=layout_y(rect->y);
+  scaled.w=layout_x(rect->x+rect->w)-scaled.x;
+  scaled.h=layout_y(rect->y+rect->h)-scaled.y;
+  SDL_FillRect(dst,&scaled,color);
+}
+
+///////////////////////////////////
+/*  Lines, as thick as a scaled  */
+/*  pixel                        */
+///////////////////////////////////
+void layout_hline(SDL_Surface* dst, int x0, int x1, int y, Uint32 color)
+{
+  int top=layout_y(y);
+  int bottom=layout_y(y+1);
+  for(int f=top;f<bottom || f==top;f++)
+    draw_hline(dst,layout_x(x0),layout_x(x1+1)-1,f,color);
+}
+
+void layout_vline(SDL_Surface* dst, int x, int y0, int y1, Uint32 color)
+{
+  int left=layout_x(x);
+  int right=layout_x(x+1);
+  for(int f=left;f<right || f==left;f++)
+    draw_vline(dst,f,layout_y(y0),layout_y(y1+1)-1,color);
+}
+
+void layout_line(SDL_Surface* dst, int x0, int y0, int x1, int y1, Uint32 color)
+{
+  int thick=layout_len(1);
+  for(int f=0;f<thick || f==0;f++)
+    draw_line(dst,layout_x(x0)+f,layout_y(y0),layout_x(x1)+f,layout_y(y1),color);
+}
+
+void layout_rect(SDL_Surface* dst, int x, int y, int w, int h, Uint32 color)
+{
+  layout_hline(dst,x,x+w-1,y,color);
+  layout_hline(dst,x,x+w-1,y+h-1,color);
+  layout_vline(dst,x,y,y+h-1,color);
+  layout_vline(dst,x+w-1,y,y+h-1,color);
+}
+
+void layout_ellipse(SDL_Surface* dst, int cx, int cy, int rx, int ry, Uint32 color)
+{
+  int thick=layout_len(1);
+  for(int f=0;f<thick || f==0;f++)
+    draw_ellipse(dst,layout_x(cx),layout_y(cy),layout_len(rx)-f,layout_len(ry)-f,color);
+}
@@ -0,0 +1,70 @@
+/*
+  RG350 Test
+  Layout of the app in any video mode: positions are 320x240 and they
+  are scaled to the mode with the table of known panels. Sprites are
+  scaled once, when the mode is set, and kept in a cache.
+*/
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define LAYOUT_WIDTH    320   // size of the positions used by the app
+#define LAYOUT_HEIGHT   240
+
+#define LAYOUT_NEAREST  0
+#define LAYOUT_SMOOTH   1
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct ui_layout
+{
+  int w,h;            // video mode
+  int num,den;        // scale num/den
+  int x,y;            // offset to center the app
+  int filter;         // sprite scaling, LAYOUT_NEAREST or LAYOUT_SMOOTH
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern ui_layout layout;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void layout_set(int w, int h);
+void layout_register(SDL_Surface* src);
+SDL_Surface* layout_sprite(SDL_Surface* src);
+void layout_end();
+void layout_fill(SDL_Surface* dst, SDL_Rect* rect, Uint32 color);
+void layout_hline(SDL_Surface* dst, int x0, int x1, int y, Uint32 color);
+void layout_vline(SDL_Surface* dst, int x, int y0, int y1, Uint32 color);
+void layout_line(SDL_Surface* dst, int x0, int y0, int x1, int y1, Uint32 color);
+void layout_rect(SDL_Surface* dst, int x, int y, int w, int h, Uint32 color);
+void layout_ellipse(SDL_Surface* dst, int cx, int cy, int rx, int ry, Uint32 color);
+
+///////////////////////////////////
+/*  Scale positions and sizes    */
+///////////////////////////////////
+inline int layout_x(int x)
+{
+  return layout.x+x*layout.num/layout.den;
+}
+
+inline int layout_y(int y)
+{
+  return layout.y+y*layout.num/layout.den;
+}
+
+inline int layout_len(int len)
+{
+  return len*layout.num/layout.den;
+}
+
+#endif
@@ -15,13 +15,43 @@
 ///////////////////////////////////
 #include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <stdlib.h>
 #include <math.h>
+#include <time.h>
 #include <pthread.h>
-#include <shake.h>  // rumble lib
 #include <SDL/SDL.h>
 #include <SDL/SDL_image.h>
 #include <SDL/SDL_ttf.h>
 #include <SDL/SDL_mixer.h>
+#include "sdmonitor.h"
+#include "cpubench.h"
+#include "cpufreq.h"
+#include "memprobe.h"
+#include "ramtest.h"
+#include "draw.h"
+#include "sprite.h"
+#include "videobench.h"
+#include "modebench.h"
+#include "vsynctest.h"
+#include "sleeptest.h"
+#include "profiler.h"
+#include "present.h"
+#include "testpattern.h"
+#include "postfx.h"
+#include "layout.h"
+#include "synth.h"
+#include "audio.h"
+#include "audiotest.h"
+#include "audiodrift.h"
+#include "stream.h"
+#include "scope.h"
+#include "fft.h"
+#include "rumble.h"
+#include "factory.h"
+#include "report.h"
+#include "history.h"
+#include "battery.h"
+#include "timing.h"
 
 ///////////////////////////////////
 /*  Joystick codes               */
@@ -48,6 +78,28 @@
 //#define GCW_BUTTON_VOLDOWN      0
 #define GCW_JOYSTICK_DEADZONE   1000
 
+///////////////////////////////////
+/*  Screens                      */
+///////////////////////////////////
+#define SCREEN_MAIN     0
+#define SCREEN_CPUFREQ  1
+#define SCREEN_MEMORY   2
+#define SCREEN_RAMTEST  3
+#define SCREEN_VIDEO    4
+#define SCREEN_MODES    5
+#define SCREEN_VSYNC    6
+#define SCREEN_SLEEP    7
+#define SCREEN_PATTERN  8
+#define SCREEN_AUDIO    9
+#define SCREEN_DRIFT    10
+#define SCREEN_STREAM   11
+#define SCREEN_SCOPE    12
+#define SCREEN_RUMBLE   13
+#define SCREEN_FACTORY  14
+#define SCREEN_HISTORY  15
+#define SCREEN_BATTERY  16
+#define SCREEN_COUNT    17
+
 #define TRUE   1
 #define FALSE  0
 #define PI 3.1415926
@@ -119,15 +171,19 @@ struct sd_data
 ///////////////////////////////////
 /*  Globals                      */
 ///////////////////////////////////
-SDL_Surface* screen;   		    // screen to work
+SDL_Surface* display;          // video mode surface
+SDL_Surface* screen;   		    // screen to work: the display, the postfx buffer or a back buffer of the present thread
 int done=0;
 TTF_Font* font;                 // used font
 SDL_Joystick* joystick;         // used joystick
 joystick_state mainjoystick;
 mouse_state mainmouse;
 int volume=120;
-int scanlines=0;
-int fullscreen=0;
+int scanlines=0;            // darken odd rows of the display
+int fullscreen=0;           // 640x480 mode with the app scaled 2x
+int native_mode=0;          // mode of the panel, the layout is scaled
+int native_w=320;           // size of the panel
+int native_h=240;
 Uint8* keys=SDL_GetKeyState(NULL);
 int rg_x=90;
 int rg_y=50;
@@ -135,9 +191,6 @@ int last_pressedkey=0;
 int battery_level=0;
 int battery_charging=0;
 Uint32 battery_checktime=0;
-int lastChecking=SDL_GetTicks();
-int batt_average[10]={0,0,0,0,0,0,0,0,0,0};   // Array con los últimos 10 valores leídos de la batería
-int battavg_idx=0;                            // Índice al valor que toca actualizar en la próxima lectura
 int mouse_active=0;
 //int sd1_readed=0;       // 0=no exist, 1=reading, 2=readed
 //int sd2_readed=0;
@@ -151,15 +204,28 @@ int cpu_clock_value;
 
 // strings
 int view_author=FALSE;
+int app_screen=SCREEN_MAIN;
+int frame_pacing=1;         // 0=SDL_Delay, 1=clock_nanosleep until an absolute deadline
+double loop_hz=0;           // real frames per second of the main loop
+int profiler_visible=0;
+// test asked in this frame, it starts when the frame is on screen
+void (*test_start)()=NULL;
+void (*test_wait)()=NULL;
+int pattern_current=0;
+int rumble_selected=0;
+Uint32 pattern_time=0;      // pattern changed, its name is shown 2 seconds
 const char* author="(c) Rafa Vico 2019";
 const char* version="1.4";
-const char* msg[6]={
+const char* msg[9]={
 "Press L1 + START to exit.",
-"Press L1 + X to play a sound.",
+"Press L1 + X/Y to play/change sound.",
 "Last detected key:",
 "Press L2 + R2 to rumble.",
 "Press POWER + R1 to de/activate mouse.",
-"reading..."
+"reading...",
+"Press SELECT + L1/R1 to change screen.",
+"Press A to start.",
+"running..."
 };
 
 const char* key_table[18]={
@@ -270,8 +336,6 @@ SDL_Surface *sdcard_2;
 SDL_Surface *rg350_cpu;
 SDL_Surface *speakersound_1;
 SDL_Surface *speakersound_2;
-//sonidos
-Mix_Chunk *sound_tone;
 
 button_state joy1;
 button_state joy2;
@@ -293,10 +357,6 @@ button_state btnpw;
 button_state btnvu;
 button_state btnvd;
 
-Shake_Device *device;
-Shake_Effect effect;
-int shake_id;
-
 ///////////////////////////////////
 /*  Function declarations        */
 ///////////////////////////////////
@@ -329,38 +389,6 @@ void Logger( std::string logMsg )
     ofs.close();
 }*/
 
-///////////////////////////////////
-/*  Draw a pixel in surface      */
-///////////////////////////////////
-void putpixel(SDL_Surface *dst, int x, int y, Uint32 pixel)
-{
-    int byteperpixel = dst->format->BytesPerPixel;
-    Uint8 *p = (Uint8*)dst->pixels + y * dst->pitch + x * byteperpixel;
-    // Adress to pixel
-    *(Uint32 *)p = pixel;
-}
-
-///////////////////////////////////
-/*  Draw a line in surface       */
-///////////////////////////////////
-void drawLine(SDL_Surface* dst, int x0, int y0, int x1, int y1, Uint32 pixel)
-{
-    int i;
-    double x = x1 - x0;
-    double y = y1 - y0;
-    double length = sqrt( x*x + y*y );
-    double addx = x / length;
-    double addy = y / length;
-    x = x0;
-    y = y0;
-
-    for ( i = 0; i < length; i += 1) {
-        putpixel(dst, x, y, pixel);
-        x += addx;
-        y += addy;
-    }
-}
-
 ///////////////////////////////////
 /*  Print text in surface        */
 ///////////////////////////////////
@@ -372,7 +400,7 @@ void draw_text(SDL_Surface* dst, char* string, int x, int y, int fR, int fG, int
     SDL_Surface *textSurface=TTF_RenderText_Blended(font,string,foregroundColor);
     if(textSurface)
     {
-      SDL_Rect textLocation={x,y,0,0};
+      SDL_Rect textLocation={(Sint16)layout_x(x),(Sint16)layout_y(y),0,0};
       SDL_BlitSurface(textSurface,NULL,dst,&textLocation);
       SDL_FreeSurface(textSurface);
     }
@@ -387,7 +415,24 @@ int text_width(char* string)
   int nx=0,ny=0;
   TTF_SizeText(font,string,&nx,&ny);
 
-  return nx;
+  return nx*layout.den/layout.num;
+}
+
+///////////////////////////////////
+/*  Load font with the size of   */
+/*  the layout                   */
+///////////////////////////////////
+void load_font()
+{
+  static int font_size=0;
+  int size=8*layout.num/layout.den;
+
+  if(font && size==font_size)
+    return;
+  if(font)
+    TTF_CloseFont(font);
+  font=TTF_OpenFont("media/pixelberry.ttf", size);
+  font_size=size;
 }
 
 ///////////////////////////////////
@@ -463,6 +508,15 @@ void sdsize(const char* path, sd_data& result) {
 	}
 }
 
+///////////////////////////////////
+/*  Close mount table when the   */
+/*  disks thread is cancelled    */
+///////////////////////////////////
+static void readdisks_end(void* p)
+{
+  sdmon_close(*(sd_monitor*)p);
+}
+
 ///////////////////////////////////
 /*  Thread that read the disks   */
 ///////////////////////////////////
@@ -473,14 +527,44 @@ static void* readdisks_thd(void* p)
   sdsize("/usr/local/home",sd_1);
   sd_1.status=2;
 
-  // card2
-  struct stat buffer;
-  if(stat("/media/sdcard/", &buffer)==0)
+  // card2, can be inserted or removed while the app is running
+  // fake mount table, to test on a PC
+  const char* mounts=getenv("RG350TEST_MOUNTS");
+  if(!mounts)
+    mounts="/proc/self/mounts";
+  sd_monitor mon;
+  if(!sdmon_open(mon,mounts,"/media/sdcard/"))
+  {
+    // no mount table, read the card only once
+    struct stat buffer;
+    if(stat("/media/sdcard/", &buffer)==0)
+    {
+      sd_2.status=1;
+      sdsize("/media/sdcard/",sd_2);
+      sd_2.status=2;
+    }
+    return NULL;
+  }
+
+  pthread_cleanup_push(readdisks_end,&mon);
+  int changed=1;
+  while(1)
   {
-    sd_2.status=1;
-    sdsize("/media/sdcard/",sd_2);
-    sd_2.status=2;
+    if(changed)
+    {
+      if(mon.mounted)
+      {
+        sd_2.status=1;
+        sdsize("/media/sdcard/",sd_2);
+        sd_2.status=2;
+      }
+      else
+        sd_2.status=0;
+    }
+    // poll() is a cancellation point, the thread ends here when the app exits
+    changed=sdmon_wait(mon,1000);
   }
+  pthread_cleanup_pop(1);
 	return NULL;
 }
 
@@ -504,64 +588,6 @@ unsigned short is_batterycharging()
 	}
 }
 
-///////////////////////////////////
-/*  Read battery level           */
-///////////////////////////////////
-unsigned short get_batterylevel()
-{
-  int battval=0;
-
-  if((SDL_GetTicks()-lastChecking)>120000)
-    batt_average[battavg_idx]=0;
-
-  if(batt_average[battavg_idx]==0 || (SDL_GetTicks()-lastChecking)>5000) {
-    lastChecking=SDL_GetTicks();
-
-    FILE *batteryHandle = NULL;
-    batteryHandle = fopen("/sys/class/power_supply/battery/voltage_now", "r");
-    if (batteryHandle) {
-      /* voltaje maximo de la RG es 4320000 */
-#define MAX_VOLTAGE 4200000
-#define MIN_VOLTAGE 3310000
-      /* voltaje maximo de la RG es 4385000 con el cable USB */
-#define USB_VOLTAGE 65000
-
-      fscanf(batteryHandle, "%d", &battval);
-      if (is_batterycharging()) {
-        battval=((battval - MIN_VOLTAGE) - USB_VOLTAGE) * 100 / (MAX_VOLTAGE - MIN_VOLTAGE);
-      } else {
-        battval=(battval - MIN_VOLTAGE) * 100 / (MAX_VOLTAGE - MIN_VOLTAGE);
-      }
-      fclose(batteryHandle);
-
-      if(battval>100)
-        battval=100;
-      else if(battval<0)
-        battval=0;
-
-      // si el array está a 0, estamos leyendo por primera vez, actualizamos el array completo
-      if(batt_average[battavg_idx]==0) {
-        for(int f=0; f<10; f++)
-          batt_average[f]=battval;
-        return battval;
-      }
-
-      // actualizamos la casilla del array con el nuevo valor leído
-      batt_average[battavg_idx++]=battval;
-      if(battavg_idx>9)
-        battavg_idx=0;
-    }
-  }
-
-  // calculamos la media de los últimos 10 valores leídos
-  battval=0;
-  for(int f=0; f<10; f++)
-    battval=battval+batt_average[f];
-  battval=battval/10;
-
-  return battval;
-}
-
 ///////////////////////////////////
 /*  Return description key text  */
 ///////////////////////////////////
@@ -576,22 +602,21 @@ const char* get_keydata(int value)
   return key_table[17]; // message "Not defined"
 }
 
+///////////////////////////////////
+/*  Read cpu clock               */
+///////////////////////////////////
 void get_cpuclock()
 {
-	FILE *cpuclockinfo=NULL;
-
-	cpuclockinfo = fopen("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq", "r");
-	if(cpuclockinfo)
-	{
-		fscanf(cpuclockinfo,"%d",&cpu_clock_value);
-		cpu_clock_value=cpu_clock_value/1000;
-		fclose(cpuclockinfo);
-		sprintf(cpu_clock,"%d MHz",cpu_clock_value);
-	}
-	else
-	{
+  int khz=cpufreq_read("cpuinfo_cur_freq");
+  if(khz>0)
+  {
+    cpu_clock_value=khz/1000;
+    sprintf(cpu_clock,"%d MHz",cpu_clock_value);
+  }
+  else
+  {
     sprintf(cpu_clock,"???");
-	}
+  }
 }
 
 ///////////////////////////////////
@@ -644,65 +669,61 @@ void clear_mouse_state()
 }
 
 ///////////////////////////////////
-/*  Init rumble device           */
+/*  Load graphic with alpha      */
 ///////////////////////////////////
-void init_rumble()
+void load_imgalpha(const char* file, SDL_Surface *&dstsurface)
 {
-	Shake_Init();
+  SDL_Surface *tmpsurface;
 
-	if (Shake_NumOfDevices() > 0)
-	{
-		device = Shake_Open(0);
-
-		Shake_InitEffect(&effect, SHAKE_EFFECT_PERIODIC);
-		effect.u.periodic.waveform		= SHAKE_PERIODIC_SINE;
-		effect.u.periodic.period			= 0.1*0x100;
-		effect.u.periodic.magnitude		= 0x6000;
-		effect.u.periodic.envelope.attackLength	= 0x100;
-		effect.u.periodic.envelope.attackLevel	= 0;
-		effect.u.periodic.envelope.fadeLength	= 0x100;
-		effect.u.periodic.envelope.fadeLevel	= 0;
-		effect.direction			= 0x4000;
-		effect.length				= 2000;
-		effect.delay				= 0;
-
-		shake_id=Shake_UploadEffect(device, &effect);
+  tmpsurface=IMG_Load(file);
+  if(tmpsurface)
+  {
+    // in the format of the screen, so blits don't convert pixels
+    SDL_PixelFormat* format=screen->format;
+    dstsurface=SDL_CreateRGBSurface(SDL_SWSURFACE, tmpsurface->w, tmpsurface->h, format->BitsPerPixel, format->Rmask,format->Gmask,format->Bmask,0);
+    if(!dstsurface)
+    {
+      SDL_FreeSurface(tmpsurface);
+      return;
     }
+    SDL_BlitSurface(tmpsurface,NULL,dstsurface,NULL);
+    SDL_SetColorKey(dstsurface,SDL_SRCCOLORKEY,SDL_MapRGB(dstsurface->format,255,0,255));
+    SDL_FreeSurface(tmpsurface);
+    // spans of opaque pixels, used by blit_sprite()
+    sprite_register(dstsurface);
+    // copy scaled to the video mode
+    layout_register(dstsurface);
+  }
 }
 
 ///////////////////////////////////
-/*  Close rumble device          */
-///////////////////////////////////
-void end_rumble()
-{
-    Shake_EraseEffect(device, shake_id);
-    Shake_Close(device);
-	Shake_Quit();
-}
-
-///////////////////////////////////
-/*  Rumble                       */
+/*  Draw a sprite at a position  */
+/*  of the layout                */
 ///////////////////////////////////
-void play_rumble()
+void blit_layout(SDL_Surface* src, SDL_Rect* dest)
 {
-    Shake_Play(device, shake_id);
+  if(!src)
+    return;
+  SDL_Rect pos;
+  pos.x=layout_x(dest->x);
+  pos.y=layout_y(dest->y);
+  blit_sprite(layout_sprite(src),screen,&pos);
 }
 
 ///////////////////////////////////
-/*  Load graphic with alpha      */
+/*  Append the session report    */
 ///////////////////////////////////
-void load_imgalpha(const char* file, SDL_Surface *&dstsurface)
+int save_report()
 {
-  SDL_Surface *tmpsurface;
-
-  tmpsurface=IMG_Load(file);
-  if(tmpsurface)
-  {
-    dstsurface=SDL_CreateRGBSurface(SDL_SRCCOLORKEY, tmpsurface->w, tmpsurface->h, 16, 0,0,0,0);
-    SDL_BlitSurface(tmpsurface,NULL,dstsurface,NULL);
-    SDL_SetColorKey(dstsurface,SDL_SRCCOLORKEY,SDL_MapRGB(screen->format,255,0,255));
-    SDL_FreeSurface(tmpsurface);
-  }
+  report_info info;
+  info.version=version;
+  info.battery_level=battery_level;
+  info.charging=is_batterycharging();
+  info.cpu_mhz=cpu_clock_value;
+  int ok=report_write(info);
+  // uses the cards measured by the report
+  history_save(info);
+  return ok;
 }
 
 ///////////////////////////////////
@@ -715,10 +736,12 @@ void init_game()
   joystick=SDL_JoystickOpen(0);
   SDL_ShowCursor(0);
 
-  Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, AUDIO_S16, MIX_DEFAULT_CHANNELS, 1024);
+  audio_open(AUDIO_RATE,AUDIO_SAMPLES);
+  scope_init();
+  fft_init();
 
   TTF_Init();
-  font=TTF_OpenFont("media/pixelberry.ttf", 8);
+  load_font();
 
   // Graphics
   load_imgalpha("media/rg350_back.png",rg350_back);
@@ -907,13 +930,21 @@ void init_game()
   btnr2.moved_time=-3000;
   btnr2.pressed_time=-3000;
 
-  // Load sounds
-  sound_tone=Mix_LoadWAV("media/tone.wav");
+  // sounds are synthesized while playing
+  synth_init();
 
   // battery and rumble init
-  init_rumble();
-  battery_level=get_batterylevel();
+  rumble_init();
+  battery_init();
+  battery_level=battery_read(is_batterycharging());
+  // fake cpufreq folder, to test on a PC
+  const char* cpufreq_folder=getenv("RG350TEST_CPUFREQ");
+  if(cpufreq_folder)
+    cpufreq_setroot(cpufreq_folder);
   get_cpuclock();
+  cpubench_start(cpu_clock_value);
+  report_start();
+  history_init();
 }
 
 ///////////////////////////////////
@@ -1020,12 +1051,25 @@ void end_game()
   if(speakersound_2)
     SDL_FreeSurface(speakersound_2);
 
-  // Free sounds
-  Mix_HaltChannel(-1);
-  Mix_FreeChunk(sound_tone);
-  Mix_CloseAudio();
+  // report before the devices are closed
+  save_report();
 
-  end_rumble();
+  // Free sounds
+  synth_stop();
+  stream_stop();
+  audiodrift_stop(drift_results);
+  audio_close();
+
+  rumble_end();
+  battery_end();
+  history_end();
+  cpufreq_sweep_end();
+  memprobe_end();
+  ramtest_stop(ram_test);
+  cpubench_end();
+  sleeptest_end();
+  layout_end();
+  sprite_unregister_all();
 }
 
 ///////////////////////////////////
@@ -1349,6 +1393,1037 @@ void process_joystick()
     mainjoystick.button_r3=1;
 }
 
+///////////////////////////////////
+/*  Draw title and help of a     */
+/*  test screen                  */
+///////////////////////////////////
+void draw_screen_title(const char* title)
+{
+  draw_text(screen,(char*)title,10,5,255,255,0);
+  draw_text(screen,(char*)msg[6],10,230,69,69,69);
+  draw_text(screen,(char*)version,300,230,69,69,69);
+}
+
+///////////////////////////////////
+/*  Draw cpu frequency sweep     */
+///////////////////////////////////
+void draw_cpufreq()
+{
+  char text[40];
+
+  draw_screen_title("CPU frequency sweep");
+  if(freq_sweep.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(freq_sweep.status==1)
+    draw_text(screen,(char*)msg[8],10,20,255,255,255);
+  else if(freq_sweep.writable)
+    draw_text(screen,(char*)"Forced steps. Press A to repeat.",10,20,192,192,192);
+  else
+    draw_text(screen,(char*)"Governor steps. Press A to repeat.",10,20,192,192,192);
+
+  int count=freq_sweep.count;
+  if(count==0)
+    return;
+
+  // graph, work per second against MHz
+  const int gx=20,gy=40,gw=170,gh=160;
+  int min_mhz=freq_sweep.steps[0].mhz;
+  int max_mhz=freq_sweep.steps[count-1].mhz;
+  double max_alu=1,max_mem=1;
+  int f;
+  for(f=0;f<count;f++)
+  {
+    if(freq_sweep.steps[f].alu>max_alu)
+      max_alu=freq_sweep.steps[f].alu;
+    if(freq_sweep.steps[f].mem>max_mem)
+      max_mem=freq_sweep.steps[f].mem;
+  }
+  layout_line(screen,gx,gy,gx,gy+gh,SDL_MapRGB(screen->format,128,128,128));
+  layout_line(screen,gx,gy+gh,gx+gw,gy+gh,SDL_MapRGB(screen->format,128,128,128));
+  sprintf(text,"%d",min_mhz);
+  draw_text(screen,text,gx,gy+gh+2,128,128,128);
+  sprintf(text,"%d MHz",max_mhz);
+  draw_text(screen,text,gx+gw-text_width(text),gy+gh+2,128,128,128);
+  draw_text(screen,(char*)"alu",gx+4,gy,64,192,64);
+  draw_text(screen,(char*)"mem",gx+24,gy,0,192,192);
+
+  int last_x=0,last_alu=0,last_mem=0;
+  for(f=0;f<count;f++)
+  {
+    cpufreq_step& step=freq_sweep.steps[f];
+    int x=gx+gw/2;
+    if(max_mhz>min_mhz)
+      x=gx+(step.mhz-min_mhz)*gw/(max_mhz-min_mhz);
+    int y_alu=gy+gh-(int)(step.alu*gh/max_alu);
+    int y_mem=gy+gh-(int)(step.mem*gh/max_mem);
+    if(f>0)
+    {
+      layout_line(screen,last_x,last_alu,x,y_alu,SDL_MapRGB(screen->format,64,192,64));
+      layout_line(screen,last_x,last_mem,x,y_mem,SDL_MapRGB(screen->format,0,192,192));
+    }
+    // steps that don't scale are marked in red
+    SDL_Rect mark={(Sint16)(x-1),(Sint16)(y_alu-1),3,3};
+    layout_fill(screen,&mark,step.slow_cpu?SDL_MapRGB(screen->format,255,0,0):SDL_MapRGB(screen->format,64,192,64));
+    mark.y=y_mem-1;
+    layout_fill(screen,&mark,step.slow_mem?SDL_MapRGB(screen->format,255,0,0):SDL_MapRGB(screen->format,0,192,192));
+    last_x=x;
+    last_alu=y_alu;
+    last_mem=y_mem;
+  }
+
+  // table
+  draw_text(screen,(char*)"MHz   Mops   MB/s",205,30,192,192,192);
+  for(f=0;f<count && f<20;f++)
+  {
+    cpufreq_step& step=freq_sweep.steps[f];
+    sprintf(text,"%4d",step.mhz);
+    draw_text(screen,text,205,40+f*9,255,255,255);
+    sprintf(text,"%5.0f",step.alu);
+    if(step.slow_cpu)
+      draw_text(screen,text,230,40+f*9,255,64,64);
+    else
+      draw_text(screen,text,230,40+f*9,64,192,64);
+    sprintf(text,"%5.0f",step.mem);
+    if(step.slow_mem)
+      draw_text(screen,text,265,40+f*9,255,64,64);
+    else
+      draw_text(screen,text,265,40+f*9,0,192,192);
+  }
+}
+
+///////////////////////////////////
+/*  Draw memory probe            */
+///////////////////////////////////
+void draw_memprobe()
+{
+  char text[40];
+
+  draw_screen_title("Memory hierarchy");
+  if(mem_probe.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(mem_probe.status==1)
+    draw_text(screen,(char*)msg[8],10,20,255,255,255);
+
+  int count=mem_probe.count;
+  if(count==0)
+    return;
+
+  // graph, latency against working set (log scale)
+  const int gx=20,gy=40,gw=192,gh=150;
+  double max_ns=1;
+  int f;
+  for(f=0;f<count;f++)
+    if(mem_probe.latency_ns[f]>max_ns)
+      max_ns=mem_probe.latency_ns[f];
+  layout_line(screen,gx,gy,gx,gy+gh,SDL_MapRGB(screen->format,128,128,128));
+  layout_line(screen,gx,gy+gh,gx+gw,gy+gh,SDL_MapRGB(screen->format,128,128,128));
+  draw_text(screen,(char*)"2K",gx,gy+gh+2,128,128,128);
+  draw_text(screen,(char*)"8M",gx+gw-text_width((char*)"8M"),gy+gh+2,128,128,128);
+  sprintf(text,"%.0f ns",max_ns);
+  draw_text(screen,text,gx+4,gy,128,128,128);
+
+  int last_x=0,last_y=0;
+  for(f=0;f<count;f++)
+  {
+    int x=gx+f*gw/(MEMPROBE_SIZES-1);
+    int y=gy+gh-(int)(mem_probe.latency_ns[f]*gh/max_ns);
+    if(f>0)
+      layout_line(screen,last_x,last_y,x,y,SDL_MapRGB(screen->format,255,192,0));
+    last_x=x;
+    last_y=y;
+  }
+
+  // results
+  if(mem_probe.status!=2)
+    return;
+  const int tx=222;
+  sprintf(text,"line  %d B",mem_probe.line_size);
+  draw_text(screen,text,tx,40,255,255,255);
+  if(mem_probe.l1_kb)
+    sprintf(text,"L1    %d KiB",mem_probe.l1_kb);
+  else
+    sprintf(text,"L1    ?");
+  draw_text(screen,text,tx,50,255,255,255);
+  if(mem_probe.l2_kb)
+    sprintf(text,"L2    %d KiB",mem_probe.l2_kb);
+  else
+    sprintf(text,"L2    ?");
+  draw_text(screen,text,tx,60,255,255,255);
+  sprintf(text,"read  %.0f MB/s",mem_probe.read_mbs);
+  draw_text(screen,text,tx,80,64,192,64);
+  sprintf(text,"write %.0f MB/s",mem_probe.write_mbs);
+  draw_text(screen,text,tx,90,64,192,64);
+  sprintf(text,"copy  %.0f MB/s",mem_probe.copy_mbs);
+  draw_text(screen,text,tx,100,64,192,64);
+  sprintf(text,"random %.0f ns",mem_probe.random_ns);
+  draw_text(screen,text,tx,120,255,192,0);
+}
+
+///////////////////////////////////
+/*  Draw RAM test                */
+///////////////////////////////////
+void draw_ramtest()
+{
+  char text[50];
+
+  draw_screen_title("RAM test");
+  if(ram_test.status==0)
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+  else if(ram_test.status==1)
+    draw_text(screen,(char*)"Press A to stop.",10,20,255,255,255);
+  else
+  {
+    draw_text(screen,(char*)"Not enough memory.",10,20,255,64,64);
+    return;
+  }
+  if(ram_test.time==0)
+    return;
+
+  sprintf(text,"Memory tested: %u MiB",ram_test.words/(256*1024));
+  draw_text(screen,text,10,40,255,255,255);
+  if(ram_test.status==1)
+  {
+    sprintf(text,"Pattern: %s %u%%",ramtest_phasename(ram_test),(unsigned int)((double)ram_test.offset*100/ram_test.words));
+    draw_text(screen,text,10,50,255,255,255);
+  }
+  sprintf(text,"Passes: %i",ram_test.passes);
+  draw_text(screen,text,10,60,255,255,255);
+  sprintf(text,"Speed: %.2f GB/s",ram_test.bytes/ram_test.time/1000);
+  draw_text(screen,text,10,70,255,255,255);
+
+  if(ram_test.error_count==0)
+  {
+    draw_text(screen,(char*)"No errors.",10,90,64,192,64);
+    return;
+  }
+  sprintf(text,"Errors: %u",ram_test.error_count);
+  draw_text(screen,text,10,90,255,64,64);
+  for(unsigned int f=0;f<ram_test.error_count && f<RAMTEST_MAXERRORS;f++)
+  {
+    sprintf(text,"0x%08lX  bits 0x%08X",ram_test.errors[f].address,ram_test.errors[f].bits);
+    draw_text(screen,text,10,100+f*10,255,64,64);
+  }
+}
+
+///////////////////////////////////
+/*  Draw video benchmark         */
+///////////////////////////////////
+void draw_videobench()
+{
+  char text[40];
+
+  draw_screen_title("Video benchmark");
+  if(video_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(video_results.status==1)
+  {
+    draw_text(screen,(char*)msg[8],10,20,255,255,255);
+    return;
+  }
+  draw_text(screen,(char*)"Mpixels/s. Press A to repeat.",10,20,192,192,192);
+
+  double max_value=1;
+  int f;
+  for(f=0;f<video_results.count;f++)
+    if(video_results.results[f].mpixels>max_value)
+      max_value=video_results.results[f].mpixels;
+  for(f=0;f<video_results.count;f++)
+  {
+    videobench_result& result=video_results.results[f];
+    int y=30+f*8;
+    draw_text(screen,(char*)result.name,10,y,255,255,255);
+    if(result.mpixels<=0)
+    {
+      draw_text(screen,(char*)"n/a",110,y,128,128,128);
+      continue;
+    }
+    SDL_Rect bar={110,(Sint16)(y+2),(Uint16)(result.mpixels*150/max_value),5};
+    layout_fill(screen,&bar,SDL_MapRGB(screen->format,64,128,192));
+    sprintf(text,"%.1f",result.mpixels);
+    draw_text(screen,text,265,y,255,255,255);
+  }
+}
+
+///////////////////////////////////
+/*  Draw video modes benchmark   */
+///////////////////////////////////
+void draw_modebench()
+{
+  char text[40];
+
+  draw_screen_title("Video modes");
+  if(mode_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(mode_results.status==1)
+  {
+    draw_text(screen,(char*)msg[8],10,20,255,255,255);
+    return;
+  }
+  draw_text(screen,(char*)"mode",10,20,192,192,192);
+  draw_text(screen,(char*)"buffer",110,20,192,192,192);
+  draw_text(screen,(char*)"IPU",160,20,192,192,192);
+  draw_text(screen,(char*)"fps",220,20,192,192,192);
+  draw_text(screen,(char*)"cpu ms",265,20,192,192,192);
+
+  // cheapest mode per frame in green
+  int best=-1;
+  int f;
+  for(f=0;f<mode_results.count;f++)
+    if(mode_results.rows[f].ok && (best<0 || mode_results.rows[f].cpu_ms<mode_results.rows[best].cpu_ms))
+      best=f;
+  for(f=0;f<mode_results.count;f++)
+  {
+    modebench_row& row=mode_results.rows[f];
+    int y=30+f*8;
+    int green=(f==best)?255:192;
+    sprintf(text,"%ix%ix%i",row.w,row.h,row.bpp);
+    draw_text(screen,text,10,y,255,255,255);
+    if(!row.ok)
+    {
+      draw_text(screen,(char*)"n/a",110,y,128,128,128);
+      continue;
+    }
+    if(row.doublebuf && !row.got_doublebuf)
+      draw_text(screen,(char*)"single*",110,y,255,192,64);
+    else
+      draw_text(screen,(char*)(row.got_doublebuf?"double":"single"),110,y,255,255,255);
+    draw_text(screen,row.ipu,160,y,255,255,255);
+    sprintf(text,"%.1f",row.fps);
+    draw_text(screen,text,220,y,192,green,192);
+    sprintf(text,"%.2f",row.cpu_ms);
+    draw_text(screen,text,265,y,192,green,192);
+  }
+}
+
+///////////////////////////////////
+/*  Draw vsync test              */
+///////////////////////////////////
+void draw_vsync()
+{
+  static int bar_x=0;
+  char text[50];
+  int f;
+
+  // fast bar, it breaks in two if flips don't wait the vblank
+  SDL_Rect bar={(Sint16)bar_x,15,16,210};
+  layout_fill(screen,&bar,SDL_MapRGB(screen->format,255,255,255));
+  bar_x=(bar_x+8)%(320-16);
+
+  draw_screen_title("Vsync");
+  if(vsync_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(vsync_results.status==1)
+  {
+    sprintf(text,"%s %i/%i",msg[8],vsync_results.count,VSYNC_SAMPLES);
+    draw_text(screen,text,10,20,255,255,255);
+    return;
+  }
+
+  if(vsync_results.locked)
+  {
+    sprintf(text,"Vsync locked: %.3f Hz",1000000/vsync_results.period_us);
+    draw_text(screen,text,10,20,64,192,64);
+    sprintf(text,"Period: %.1f us  jitter: %.1f us",vsync_results.period_us,vsync_results.jitter_us);
+    draw_text(screen,text,10,30,255,255,255);
+    sprintf(text,"Missed vblanks: %i of %i flips",vsync_results.missed,vsync_results.count);
+    if(vsync_results.missed)
+      draw_text(screen,text,10,40,255,64,64);
+    else
+      draw_text(screen,text,10,40,255,255,255);
+  }
+  else
+  {
+    draw_text(screen,(char*)"Not vsync locked, tearing expected.",10,20,255,64,64);
+    if(vsync_results.period_us>0)
+    {
+      sprintf(text,"Period: %.1f us  jitter: %.1f us",vsync_results.period_us,vsync_results.jitter_us);
+      draw_text(screen,text,10,30,255,255,255);
+    }
+  }
+  sprintf(text,"Flips: %.1f/s",vsync_results.flips);
+  draw_text(screen,text,10,50,255,255,255);
+
+  // flip intervals, 1 pixel every 500 us
+  Uint32 color=SDL_MapRGB(screen->format,64,128,192);
+  for(f=0;f<vsync_results.count;f++)
+  {
+    int h=vsync_results.intervals[f]/500;
+    if(h>100)
+      h=100;
+    layout_vline(screen,10+f,220-h,220,color);
+  }
+}
+
+///////////////////////////////////
+/*  Draw sleep accuracy test     */
+///////////////////////////////////
+void draw_sleeptest()
+{
+  char text[50];
+  int f,m;
+
+  draw_screen_title("Sleep accuracy");
+  sprintf(text,"Loop: %.2f Hz with %s. B: change.",loop_hz,frame_pacing?"deadline":"SDL_Delay");
+  draw_text(screen,text,10,215,192,192,192);
+  if(sleep_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(sleep_results.status==1)
+  {
+    draw_text(screen,(char*)msg[8],10,20,255,255,255);
+    return;
+  }
+
+  // mean and max overshoot of every sleep time, measured with the loop stopped
+  draw_text(screen,(char*)"Overshoot us, mean/max, app idle",10,20,192,192,192);
+  draw_text(screen,(char*)"ms",10,32,192,192,192);
+  for(m=0;m<SLEEP_METHODS;m++)
+    draw_text(screen,(char*)sleep_names[m],40+m*90,32,192,192,192);
+  for(f=0;f<SLEEP_REQUESTS;f++)
+  {
+    int y=42+f*9;
+    sprintf(text,"%i",sleep_requests_ms[f]);
+    draw_text(screen,text,10,y,255,255,255);
+    for(m=0;m<SLEEP_METHODS;m++)
+    {
+      sprintf(text,"%.0f/%u",sleep_results.methods[m].mean_us[f],sleep_results.methods[m].max_us[f]);
+      draw_text(screen,text,40+m*90,y,255,255,255);
+    }
+  }
+
+  // histograms of all the sleeps
+  Uint32 color=SDL_MapRGB(screen->format,64,128,192);
+  for(f=0;f<SLEEP_BINS;f++)
+  {
+    int y=105+f*12;
+    draw_text(screen,(char*)sleep_binnames[f],10,y,192,192,192);
+    for(m=0;m<SLEEP_METHODS;m++)
+    {
+      unsigned int total=0;
+      for(int b=0;b<SLEEP_BINS;b++)
+        total+=sleep_results.methods[m].histogram[b];
+      if(total==0)
+        continue;
+      SDL_Rect bar={(Sint16)(40+m*90),(Sint16)(y+2),(Uint16)(sleep_results.methods[m].histogram[f]*80/total),7};
+      layout_fill(screen,&bar,color);
+    }
+  }
+}
+
+///////////////////////////////////
+/*  Draw test pattern            */
+///////////////////////////////////
+void draw_pattern()
+{
+  static int frame=0;
+
+  pattern_draw(screen,pattern_current,frame++);
+  // name only for a while, it covers pixels
+  if(SDL_GetTicks()-pattern_time<2000)
+  {
+    draw_text(screen,(char*)pattern_names[pattern_current],10,5,128,128,128);
+    draw_text(screen,(char*)"LEFT/RIGHT: change pattern.",10,230,128,128,128);
+  }
+}
+
+///////////////////////////////////
+/*  Draw audio latency test      */
+///////////////////////////////////
+void draw_audiotest()
+{
+  char text[40];
+  int r,b;
+
+  draw_screen_title("Audio latency");
+  if(audio_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(audio_results.status==1)
+  {
+    r=audio_results.current/AUDIOTEST_BUFFERS;
+    b=audio_results.current%AUDIOTEST_BUFFERS;
+    sprintf(text,"%s %i Hz, %i samples",msg[8],audiotest_rates[r],audiotest_buffers[b]);
+    draw_text(screen,text,10,20,255,255,255);
+    return;
+  }
+
+  // a cell per config: latency, then jitter and underruns
+  draw_text(screen,(char*)"buffer",10,20,192,192,192);
+  for(r=0;r<AUDIOTEST_RATES;r++)
+  {
+    sprintf(text,"%i Hz",audiotest_rates[r]);
+    draw_text(screen,text,60+r*85,20,192,192,192);
+  }
+  int best_r=-1,best_b=-1;
+  for(b=0;b<AUDIOTEST_BUFFERS;b++)
+  {
+    int y=32+b*22;
+    sprintf(text,"%i",audiotest_buffers[b]);
+    draw_text(screen,text,10,y,255,255,255);
+    for(r=0;r<AUDIOTEST_RATES;r++)
+    {
+      audiotest_result& result=audio_results.results[r][b];
+      int x=60+r*85;
+      if(!result.ok || result.callbacks==0)
+      {
+        draw_text(screen,(char*)"n/a",x,y,128,128,128);
+        continue;
+      }
+      if(result.safe && (best_r<0 || result.latency_ms<audio_results.results[best_r][best_b].latency_ms))
+      {
+        best_r=r;
+        best_b=b;
+      }
+      sprintf(text,"%.1f ms",result.latency_ms);
+      draw_text(screen,text,x,y,255,255,255);
+      sprintf(text,"j%.2f u%i",result.jitter_ms,result.underruns);
+      if(result.safe)
+        draw_text(screen,text,x,y+9,64,192,64);
+      else
+        draw_text(screen,text,x,y+9,192,64,64);
+    }
+  }
+  draw_text(screen,(char*)"j=jitter ms, u=underruns",10,166,128,128,128);
+  if(best_r<0)
+    sprintf(text,"No safe config");
+  else
+    sprintf(text,"Lowest safe: %i samples at %i Hz",audiotest_buffers[best_b],audio_results.results[best_r][best_b].rate);
+  draw_text(screen,text,10,178,255,255,0);
+}
+
+///////////////////////////////////
+/*  Draw audio clock drift       */
+///////////////////////////////////
+void draw_audiodrift()
+{
+  char text[50];
+
+  draw_screen_title("Audio clock");
+  if(drift_results.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    return;
+  }
+  if(drift_results.status==3)
+  {
+    draw_text(screen,(char*)"Audio not available.",10,20,192,64,64);
+    return;
+  }
+  if(drift_results.status==1)
+  {
+    sprintf(text,"%s %.0f/%i s, A to stop.",msg[8],drift_results.seconds,AUDIODRIFT_TIME);
+    draw_text(screen,text,10,20,255,255,255);
+    SDL_Rect bar={10,32,(Uint16)(300*drift_results.seconds/AUDIODRIFT_TIME),6};
+    layout_fill(screen,&bar,SDL_MapRGB(screen->format,64,128,192));
+  }
+  else
+    draw_text(screen,(char*)"Done.",10,20,255,255,255);
+
+  sprintf(text,"nominal rate: %i Hz",drift_results.rate);
+  draw_text(screen,text,10,50,192,192,192);
+  sprintf(text,"samples: %llu",drift_results.samples);
+  draw_text(screen,text,10,60,192,192,192);
+  if(drift_results.real_rate<=0)
+    return;
+  sprintf(text,"real rate: %.2f Hz",drift_results.real_rate);
+  draw_text(screen,text,10,75,255,255,255);
+  sprintf(text,"drift: %+.1f ppm (+-%.1f)",drift_results.ppm,drift_results.error_ppm);
+  // usual crystals are inside 100 ppm
+  if(fabs(drift_results.ppm)<=100)
+    draw_text(screen,text,10,85,64,192,64);
+  else
+    draw_text(screen,text,10,85,192,64,64);
+  sprintf(text,"A/V sync off %.0f ms every hour",fabs(drift_results.ppm)*3.6);
+  draw_text(screen,text,10,95,255,255,255);
+}
+
+///////////////////////////////////
+/*  Draw music stream            */
+///////////////////////////////////
+void draw_stream()
+{
+  char text[60];
+
+  draw_screen_title("Music stream");
+  switch(stream_results.status)
+  {
+    case 0:
+      draw_text(screen,(char*)msg[7],10,20,255,255,255);
+      return;
+    case 2:
+      draw_text(screen,(char*)"Music file not found.",10,20,192,64,64);
+      return;
+    case 3:
+      sprintf(text,"Can't decode %s",stream_results.path);
+      draw_text(screen,text,10,20,192,64,64);
+      return;
+  }
+  draw_text(screen,(char*)"Playing, A to stop. Buttons keep working.",10,20,255,255,255);
+  draw_text(screen,(char*)stream_results.path,10,30,192,192,192);
+
+  sprintf(text,"decode cpu: %.1f %%",stream_results.cpu);
+  draw_text(screen,text,10,50,255,255,255);
+  sprintf(text,"read: %.2f MB/s",stream_results.read_mbs);
+  draw_text(screen,text,10,60,255,255,255);
+  sprintf(text,"stream: %.1f kB/s",stream_results.stream_kbs);
+  draw_text(screen,text,10,70,255,255,255);
+  sprintf(text,"decoder waited the SD: %u",stream_results.stalls);
+  if(stream_results.stalls)
+    draw_text(screen,text,10,80,192,64,64);
+  else
+    draw_text(screen,text,10,80,255,255,255);
+
+  // read ahead buffer
+  sprintf(text,"buffer: %.0f %%",stream_results.fill);
+  draw_text(screen,text,10,95,255,255,255);
+  SDL_Rect bar={10,106,300,8};
+  layout_rect(screen,bar.x,bar.y,bar.w,bar.h,SDL_MapRGB(screen->format,128,128,128));
+  bar.x++;
+  bar.y++;
+  bar.h-=2;
+  bar.w=(Uint16)(298*stream_results.fill/100);
+  layout_fill(screen,&bar,SDL_MapRGB(screen->format,64,128,192));
+}
+
+///////////////////////////////////
+/*  Level in dB of full scale    */
+///////////////////////////////////
+double level_db(double level)
+{
+  if(level<1)
+    return -96;
+  return 20*log10(level/32768);
+}
+
+///////////////////////////////////
+/*  Draw oscilloscope and        */
+/*  spectrum of the output mix   */
+///////////////////////////////////
+void draw_scope()
+{
+  static Uint32 clip_time=0;
+  static unsigned int clips=0;
+  Sint16 left[FFT_SIZE];
+  Sint16 right[FFT_SIZE];
+  Sint16 mono[FFT_SIZE];
+  Uint32 power[FFT_BINS];
+  char text[50];
+  int f;
+
+  draw_screen_title("Audio scope");
+  if(!scope_read(left,right,FFT_SIZE))
+    return;
+
+  // spectrum of both channels
+  unsigned long long start=time_us();
+  for(f=0;f<FFT_SIZE;f++)
+    mono[f]=(Sint16)((left[f]+right[f])/2);
+  fft_power(mono,power);
+  prof_record(PROF_FFT,(unsigned int)(time_us()-start));
+
+  // oscilloscope, left over right
+  Uint32 color_left=SDL_MapRGB(screen->format,64,192,64);
+  Uint32 color_right=SDL_MapRGB(screen->format,192,64,64);
+  layout_hline(screen,10,309,55,SDL_MapRGB(screen->format,48,48,48));
+  layout_hline(screen,10,309,115,SDL_MapRGB(screen->format,48,48,48));
+  for(f=1;f<300;f++)
+  {
+    int s0=(f-1)*FFT_SIZE/300;
+    int s1=f*FFT_SIZE/300;
+    layout_line(screen,9+f,55-left[s0]*28/32768,10+f,55-left[s1]*28/32768,color_left);
+    layout_line(screen,9+f,115-right[s0]*28/32768,10+f,115-right[s1]*28/32768,color_right);
+  }
+
+  // 128 bins from -80 dB to 0 dB
+  Uint32 color_bin=SDL_MapRGB(screen->format,64,128,192);
+  for(f=0;f<FFT_BINS;f++)
+  {
+    int height=(fft_db(power[f])+80)*60/80;
+    if(height<=0)
+      continue;
+    if(height>60)
+      height=60;
+    SDL_Rect bin={(Sint16)(32+f*2),(Sint16)(208-height),2,(Uint16)height};
+    layout_fill(screen,&bin,color_bin);
+  }
+  layout_hline(screen,32,287,208,SDL_MapRGB(screen->format,128,128,128));
+  draw_text(screen,(char*)"0",32,209,128,128,128);
+  sprintf(text,"%i Hz",audio.rate/2);
+  draw_text(screen,text,288-text_width(text),209,128,128,128);
+
+  // levels and clipping
+  double peak_l=0,peak_r=0,sum_l=0,sum_r=0;
+  for(f=0;f<FFT_SIZE;f++)
+  {
+    if(abs(left[f])>peak_l)
+      peak_l=abs(left[f]);
+    if(abs(right[f])>peak_r)
+      peak_r=abs(right[f]);
+    sum_l+=left[f]*(double)left[f];
+    sum_r+=right[f]*(double)right[f];
+  }
+  double rms_l=sqrt(sum_l/FFT_SIZE);
+  double rms_r=sqrt(sum_r/FFT_SIZE);
+  sprintf(text,"L peak %.0f rms %.0f dB",level_db(peak_l),level_db(rms_l));
+  draw_text(screen,text,10,20,64,192,64);
+  sprintf(text,"R peak %.0f rms %.0f dB",level_db(peak_r),level_db(rms_r));
+  draw_text(screen,text,10,80,192,64,64);
+  if(rms_l>=1 || rms_r>=1)
+  {
+    sprintf(text,"L-R %+.1f dB",level_db(rms_l)-level_db(rms_r));
+    draw_text(screen,text,230,20,255,255,255);
+  }
+  if(scope_clips()!=clips)
+  {
+    clips=scope_clips();
+    clip_time=SDL_GetTicks();
+  }
+  sprintf(text,"clipped: %u",clips);
+  if(SDL_GetTicks()-clip_time<1000)
+    draw_text(screen,text,230,80,255,64,64);
+  else
+    draw_text(screen,text,230,80,128,128,128);
+
+  sprintf(text,"L1 + X/Y: play/change sound, %s",synth_names[synth_mode()]);
+  draw_text(screen,text,10,220,192,192,192);
+}
+
+///////////////////////////////////
+/*  Draw rumble patterns         */
+///////////////////////////////////
+void draw_rumble()
+{
+  char text[50];
+
+  draw_screen_title("Rumble");
+  if(!rumble_results.available)
+  {
+    draw_text(screen,(char*)"No rumble device.",10,20,192,64,64);
+    return;
+  }
+  sprintf(text,"%i effects uploaded.",rumble_results.uploaded);
+  draw_text(screen,text,10,20,192,192,192);
+  draw_text(screen,(char*)"UP/DOWN: pattern, A: play.",10,30,192,192,192);
+
+  draw_text(screen,(char*)"pattern",20,45,192,192,192);
+  draw_text(screen,(char*)"last us",200,45,192,192,192);
+  for(int f=0;f<RUMBLE_PATTERNS;f++)
+  {
+    int y=55+f*10;
+    if(f==rumble_selected)
+      draw_text(screen,(char*)">",10,y,255,255,0);
+    if(f==rumble_results.playing)
+      draw_text(screen,(char*)rumble_names[f],20,y,64,192,64);
+    else
+      draw_text(screen,(char*)rumble_names[f],20,y,255,255,255);
+    if(rumble_results.pattern_us[f])
+    {
+      sprintf(text,"%u",rumble_results.pattern_us[f]);
+      draw_text(screen,text,200,y,255,255,255);
+    }
+  }
+
+  // command to Shake_Play return, of all the plays
+  if(rumble_results.plays==0)
+    return;
+  sprintf(text,"Shake_Play: %u calls",rumble_results.plays);
+  draw_text(screen,text,10,135,192,192,192);
+  sprintf(text,"latency us: last %u, avg %u, max %u",rumble_results.last_us,(unsigned int)(rumble_results.total_us/rumble_results.plays),rumble_results.max_us);
+  draw_text(screen,text,10,145,255,255,255);
+}
+
+///////////////////////////////////
+/*  Draw this unit against its   */
+/*  last run                     */
+///////////////////////////////////
+void draw_history()
+{
+  const char* names[10]={
+    "battery mV","battery %","CPU MHz","CPU score","int SD write","int SD read",
+    "ext SD write","ext SD read","left noise","right noise"
+  };
+  double values[2][10];
+  char text[50];
+  int f;
+
+  draw_screen_title("History");
+  sprintf(text,"Unit %.24s (%s)",history.id,history.source);
+  draw_text(screen,text,10,20,192,192,192);
+  if(!history.path[0])
+  {
+    draw_text(screen,(char*)"History not available.",10,35,192,64,64);
+    return;
+  }
+  sprintf(text,"%i runs in %.30s",history.runs,history.path);
+  draw_text(screen,text,10,30,192,192,192);
+  if(history.error[0])
+    draw_text(screen,history.error,10,40,192,64,64);
+  else
+    draw_text(screen,(char*)"Press A to save this session.",10,40,192,192,192);
+  if(history.kept==0)
+    return;
+
+  for(int r=0;r<2 && r<history.kept;r++)
+  {
+    const history_record& run=history.last[r];
+    values[r][0]=run.battery_mv;
+    values[r][1]=run.battery_level;
+    values[r][2]=run.cpu_mhz;
+    values[r][3]=run.cpu_score;
+    for(f=0;f<2;f++)
+    {
+      values[r][4+f*2]=run.sd_write[f]/100.0;
+      values[r][5+f*2]=run.sd_read[f]/100.0;
+    }
+    for(f=0;f<2;f++)
+      values[r][8+f]=run.stick_noise[f*2]>run.stick_noise[f*2+1]?run.stick_noise[f*2]:run.stick_noise[f*2+1];
+  }
+
+  // dates of the runs
+  for(int r=0;r<2 && r<history.kept;r++)
+  {
+    time_t when=history.last[r].time;
+    strftime(text,sizeof(text),"%m-%d %H:%M",localtime(&when));
+    draw_text(screen,text,120+r*70,55,192,192,192);
+  }
+  draw_text(screen,(char*)"last",120,45,192,192,192);
+  if(history.kept>1)
+  {
+    draw_text(screen,(char*)"previous",190,45,192,192,192);
+    draw_text(screen,(char*)"change",260,45,192,192,192);
+  }
+  for(f=0;f<10;f++)
+  {
+    int y=70+f*10;
+    // MB/s with decimals
+    const char* format=(f>=4 && f<8)?"%.2f":"%.0f";
+    draw_text(screen,(char*)names[f],10,y,192,192,192);
+    sprintf(text,format,values[0][f]);
+    draw_text(screen,text,120,y,255,255,255);
+    if(history.kept<2)
+      continue;
+    sprintf(text,format,values[1][f]);
+    draw_text(screen,text,190,y,192,192,192);
+    double change=values[0][f]-values[1][f];
+    sprintf(text,(f>=4 && f<8)?"%+.2f":"%+.0f",change);
+    // more than a tenth away
+    double base=values[1][f]>0?values[1][f]:-values[1][f];
+    if(change*change>base*base/100)
+      draw_text(screen,text,260,y,255,255,0);
+    else
+      draw_text(screen,text,260,y,192,192,192);
+  }
+}
+
+///////////////////////////////////
+/*  Draw battery table and log   */
+///////////////////////////////////
+void draw_battery()
+{
+  char text[50];
+  int f;
+
+  draw_screen_title("Battery");
+  sprintf(text,"%.3f V, smoothed %.3f V",battery.microvolts/1000000.0,battery.ema_mv/1000.0);
+  draw_text(screen,text,10,20,255,255,255);
+  if(battery.microamps)
+    sprintf(text,"%i mA, level %.1f %%",battery.microamps/1000,battery.percent);
+  else
+    sprintf(text,"level %.1f %%",battery.percent);
+  draw_text(screen,text,10,30,255,255,255);
+  if(battery.minutes_left>=0)
+    sprintf(text,"time left %i h %02i min",battery.minutes_left/60,battery.minutes_left%60);
+  else
+    sprintf(text,"time left unknown");
+  draw_text(screen,text,10,40,255,255,255);
+  if(battery.lut_measured)
+    sprintf(text,"table: measured, %.1f h",battery.lut_runtime_s/3600.0);
+  else
+    sprintf(text,"table: linear");
+  draw_text(screen,text,10,50,192,192,192);
+
+  // table: percent against voltage, 3.3 to 4.3 V
+  SDL_Rect area;
+  area.x=200;
+  area.y=20;
+  area.w=110;
+  area.h=80;
+  layout_rect(screen,area.x,area.y,area.w,area.h,SDL_MapRGB(screen->format,96,96,96));
+  for(f=1;f<BATTERY_LUTPOINTS;f++)
+  {
+    int x1=area.x+(f-1)*area.w/(BATTERY_LUTPOINTS-1);
+    int x2=area.x+f*area.w/(BATTERY_LUTPOINTS-1);
+    int y1=area.y+area.h-(battery.lut_mv[f-1]-3300)*area.h/1000;
+    int y2=area.y+area.h-(battery.lut_mv[f]-3300)*area.h/1000;
+    layout_line(screen,x1,y1,x2,y2,SDL_MapRGB(screen->format,64,192,64));
+  }
+  int x=area.x+(int)(battery.percent*area.w/100);
+  layout_vline(screen,x,area.y,area.y+area.h,SDL_MapRGB(screen->format,255,255,0));
+  draw_text(screen,(char*)"0%",area.x,area.y+area.h+2,192,192,192);
+  draw_text(screen,(char*)"100%",area.x+area.w-text_width((char*)"100%"),area.y+area.h+2,192,192,192);
+
+  // logger
+  if(battery.logging)
+  {
+    sprintf(text,"logging: %u records, a record every 10 s",battery.logged);
+    draw_text(screen,text,10,120,64,192,64);
+    sprintf(text,"write %u us, max %u us",battery.log_us,battery.log_max_us);
+    draw_text(screen,text,10,130,192,192,192);
+  }
+  else
+    draw_text(screen,(char*)"not logging",10,120,192,192,192);
+  if(battery.message[0])
+    draw_text(screen,battery.message,10,145,255,255,0);
+  draw_text(screen,(char*)"A: start/stop log, B: build table.",10,160,192,192,192);
+  draw_text(screen,(char*)"Log a full charge to empty to measure.",10,170,192,192,192);
+}
+
+///////////////////////////////////
+/*  Draw guided factory test     */
+///////////////////////////////////
+void draw_factory()
+{
+  button_state* buttons[FACTORY_BUTTONS]={
+    &padup,&paddown,&padleft,&padright,&btna,&btnb,&btnx,&btny,
+    &btnl1,&btnl2,&btnr1,&btnr2,&btnsel,&btnst,&btnvd,&btnvu,&btnpw,&joy1,&joy2
+  };
+  char text[50];
+  int f;
+
+  draw_screen_title("Factory test");
+  if(factory.status==0)
+  {
+    draw_text(screen,(char*)msg[7],10,20,255,255,255);
+    draw_text(screen,(char*)"Every button, sticks, sound, rumble and SD",10,35,192,192,192);
+    draw_text(screen,(char*)"are asked in turn.",10,45,192,192,192);
+    return;
+  }
+
+  if(factory.status==2)
+  {
+    // summary, two columns
+    int failed=FACTORY_STEPS-factory.passed;
+    if(failed==0)
+      draw_text(screen,(char*)"PASS",10,20,64,192,64);
+    else
+      draw_text(screen,(char*)"FAIL",10,20,192,64,64);
+    sprintf(text,"%i/%i ok, %.1f s, %u wrong keys",factory.passed,FACTORY_STEPS,factory.total_ms/1000.0,factory.wrong);
+    draw_text(screen,text,40,20,255,255,255);
+    for(f=0;f<FACTORY_STEPS;f++)
+    {
+      int x=10+(f/12)*155;
+      int y=35+(f%12)*10;
+      const factory_step& step=factory.steps[f];
+      draw_text(screen,(char*)factory_names[f],x,y,255,255,255);
+      if(step.result==FACTORY_PASS)
+        sprintf(text,"ok %.1f s",step.time_ms/1000.0);
+      else
+        sprintf(text,step.result==FACTORY_TIMEOUT?"timeout":"fail");
+      if(step.result==FACTORY_PASS)
+        draw_text(screen,text,x+70,y,64,192,64);
+      else
+        draw_text(screen,text,x+70,y,192,64,64);
+    }
+    if(report_path[0])
+    {
+      sprintf(text,"Report: %.40s",report_path);
+      draw_text(screen,text,10,160,192,192,192);
+    }
+    else
+      draw_text(screen,(char*)"Report not saved",10,160,192,64,64);
+    draw_text(screen,(char*)"Press A to test again.",10,170,192,192,192);
+    return;
+  }
+
+  // console with the button to press
+  SDL_Rect dest;
+  dest.x=rg_x;
+  dest.y=rg_y;
+  if(rg350_back)
+    blit_layout(rg350_back,&dest);
+  int step=factory.step;
+  if(step<FACTORY_BUTTONS)
+  {
+    button_state* button=buttons[step];
+    dest.x=button->x;
+    dest.y=button->y;
+    if(button->button_pressed && (SDL_GetTicks()/250)%2)
+      blit_layout(button->button_pressed,&dest);
+    sprintf(text,"Press %s",factory_names[step]);
+  }
+  else if(step==FACTORY_STICK1 || step==FACTORY_STICK2)
+  {
+    button_state* stick=(step==FACTORY_STICK1)?&joy1:&joy2;
+    int axis=(step-FACTORY_STICK1)*2;
+    dest.x=stick->x+SDL_JoystickGetAxis(joystick,axis)/5461;
+    dest.y=stick->y+SDL_JoystickGetAxis(joystick,axis+1)/5461;
+    if(stick->button_moved)
+      blit_layout(stick->button_moved,&dest);
+    sprintf(text,"Move the %s to all the edges",factory_names[step]);
+  }
+  else if(step==FACTORY_SOUND)
+    sprintf(text,"Sound playing? A: yes, B: no");
+  else if(step==FACTORY_RUMBLE)
+    sprintf(text,"Rumbling? A: yes, B: no");
+  else
+    sprintf(text,"Checking SD cards...");
+  draw_text(screen,text,10,180,255,255,0);
+
+  // step and time left
+  sprintf(text,"step %i/%i",step+1,FACTORY_STEPS);
+  draw_text(screen,text,10,20,192,192,192);
+  unsigned int elapsed=(unsigned int)((time_us()-factory.step_start)/1000);
+  unsigned int timeout=factory_timeout(step);
+  if(elapsed>timeout)
+    elapsed=timeout;
+  SDL_Rect bar={10,195,(Uint16)(300*(timeout-elapsed)/timeout),4};
+  layout_fill(screen,&bar,SDL_MapRGB(screen->format,64,128,192));
+}
+
+///////////////////////////////////
+/*  Draw profiler over the       */
+/*  screen                       */
+///////////////////////////////////
+void draw_profiler()
+{
+  char text[40];
+  SDL_Rect box={196,14,120,14+PROF_COUNTERS*9};
+  layout_fill(screen,&box,SDL_MapRGB(screen->format,0,0,0));
+  layout_rect(screen,box.x,box.y,box.w,box.h,SDL_MapRGB(screen->format,64,128,192));
+
+  sprintf(text,"%s  ms avg/max",present_active()?"thread":"direct");
+  draw_text(screen,text,box.x+4,box.y+2,192,192,192);
+  for(int f=0;f<PROF_COUNTERS;f++)
+  {
+    unsigned int average,max;
+    if(!prof_stats(f,average,max))
+      continue;
+    sprintf(text,"%s",prof_names[f]);
+    draw_text(screen,text,box.x+4,box.y+12+f*9,255,255,255);
+    sprintf(text,"%.2f/%.2f",average/1000.0,max/1000.0);
+    draw_text(screen,text,box.x+58,box.y+12+f*9,255,255,255);
+  }
+}
+
 ///////////////////////////////////
 /*  Draw screen, console and     */
 /*  buttons                      */
@@ -1358,12 +2433,65 @@ void draw_game()
   Uint32 time=SDL_GetTicks();
   SDL_FillRect(screen, NULL, SDL_MapRGB(screen->format,16,16,16));
 
+  // test screens
+  switch(app_screen)
+  {
+    case SCREEN_CPUFREQ:
+      draw_cpufreq();
+      return;
+    case SCREEN_MEMORY:
+      draw_memprobe();
+      return;
+    case SCREEN_RAMTEST:
+      draw_ramtest();
+      return;
+    case SCREEN_VIDEO:
+      draw_videobench();
+      return;
+    case SCREEN_MODES:
+      draw_modebench();
+      return;
+    case SCREEN_VSYNC:
+      draw_vsync();
+      return;
+    case SCREEN_SLEEP:
+      draw_sleeptest();
+      return;
+    case SCREEN_PATTERN:
+      draw_pattern();
+      return;
+    case SCREEN_AUDIO:
+      draw_audiotest();
+      return;
+    case SCREEN_DRIFT:
+      draw_audiodrift();
+      return;
+    case SCREEN_STREAM:
+      draw_stream();
+      return;
+    case SCREEN_SCOPE:
+      draw_scope();
+      return;
+    case SCREEN_RUMBLE:
+      draw_rumble();
+      return;
+    case SCREEN_FACTORY:
+      draw_factory();
+      return;
+    case SCREEN_HISTORY:
+      draw_history();
+      return;
+    case SCREEN_BATTERY:
+      draw_battery();
+      return;
+  }
+
   // console
   SDL_Rect dest;
   dest.x=rg_x;
   dest.y=rg_y;
   if(rg350_back)
-    SDL_BlitSurface(rg350_back,NULL,screen,&dest);
+    blit_layout(rg350_back,&dest);
 
   // joystick1
   dest.x=rg_x+11+SDL_JoystickGetAxis(joystick,0)/5461;   // axis value (-32767,32768), I want draw it with 6 pixels displace
@@ -1372,23 +2500,23 @@ void draw_game()
   if((time-joy1.pressed_time)<3000)
   {
     if(joy1.button_pressed)
-      SDL_BlitSurface(joy1.button_pressed,NULL,screen,&dest);
+      blit_layout(joy1.button_pressed,&dest);
     dest.x=72;
     dest.y=78;
     if(info_btnl3)
-      SDL_BlitSurface(info_btnl3,NULL,screen,&dest);
+      blit_layout(info_btnl3,&dest);
   }
   else
   {
     if((time-joy1.moved_time)<3000)
     {
         if(joy1.button_moved)
-          SDL_BlitSurface(joy1.button_moved,NULL,screen,&dest);
+          blit_layout(joy1.button_moved,&dest);
     }
     else
     {
       if(joy1.button)
-        SDL_BlitSurface(joy1.button,NULL,screen,&dest);
+        blit_layout(joy1.button,&dest);
     }
   }
 
@@ -1398,23 +2526,23 @@ void draw_game()
   if((time-joy2.pressed_time)<3000)
   {
     if(joy2.button_pressed)
-      SDL_BlitSurface(joy2.button_pressed,NULL,screen,&dest);
+      blit_layout(joy2.button_pressed,&dest);
     dest.x=221;
     dest.y=104;
     if(info_btnr3)
-      SDL_BlitSurface(info_btnr3,NULL,screen,&dest);
+      blit_layout(info_btnr3,&dest);
   }
   else
   {
     if((time-joy2.moved_time)<3000)
     {
       if(joy2.button_moved)
-        SDL_BlitSurface(joy2.button_moved,NULL,screen,&dest);
+        blit_layout(joy2.button_moved,&dest);
     }
     else
     {
       if(joy2.button)
-        SDL_BlitSurface(joy2.button,NULL,screen,&dest);
+        blit_layout(joy2.button,&dest);
     }
   }
 
@@ -1424,16 +2552,16 @@ void draw_game()
   if((time-btna.pressed_time)<3000)
   {
     if(btna.button_pressed)
-      SDL_BlitSurface(btna.button_pressed,NULL,screen,&dest);
+      blit_layout(btna.button_pressed,&dest);
     dest.x=224;
     dest.y=73;
     if(info_btna)
-      SDL_BlitSurface(info_btna,NULL,screen,&dest);
+      blit_layout(info_btna,&dest);
   }
   else
   {
     if(btna.button)
-      SDL_BlitSurface(btna.button,NULL,screen,&dest);
+      blit_layout(btna.button,&dest);
   }
   // button b
   dest.x=btnb.x;
@@ -1441,16 +2569,16 @@ void draw_game()
   if((time-btnb.pressed_time)<3000)
   {
     if(btnb.button_pressed)
-      SDL_BlitSurface(btnb.button_pressed,NULL,screen,&dest);
+      blit_layout(btnb.button_pressed,&dest);
     dest.x=216;
     dest.y=90;
     if(info_btnb)
-      SDL_BlitSurface(info_btnb,NULL,screen,&dest);
+      blit_layout(info_btnb,&dest);
   }
   else
   {
     if(btnb.button)
-      SDL_BlitSurface(btnb.button,NULL,screen,&dest);
+      blit_layout(btnb.button,&dest);
   }
   // button x
   dest.x=btnx.x;
@@ -1458,16 +2586,16 @@ void draw_game()
   if((time-btnx.pressed_time)<3000)
   {
     if(btnx.button_pressed)
-      SDL_BlitSurface(btnx.button_pressed,NULL,screen,&dest);
+      blit_layout(btnx.button_pressed,&dest);
     dest.x=216;
     dest.y=64;
     if(info_btnx)
-      SDL_BlitSurface(info_btnx,NULL,screen,&dest);
+      blit_layout(info_btnx,&dest);
   }
   else
   {
     if(btnx.button)
-      SDL_BlitSurface(btnx.button,NULL,screen,&dest);
+      blit_layout(btnx.button,&dest);
   }
   // button y
   dest.x=btny.x;
@@ -1475,16 +2603,16 @@ void draw_game()
   if((time-btny.pressed_time)<3000)
   {
     if(btny.button_pressed)
-      SDL_BlitSurface(btny.button_pressed,NULL,screen,&dest);
+      blit_layout(btny.button_pressed,&dest);
     dest.x=209;
     dest.y=82;
     if(info_btny)
-      SDL_BlitSurface(info_btny,NULL,screen,&dest);
+      blit_layout(info_btny,&dest);
   }
   else
   {
     if(btny.button)
-      SDL_BlitSurface(btny.button,NULL,screen,&dest);
+      blit_layout(btny.button,&dest);
   }
   // button up
   dest.x=padup.x;
@@ -1492,16 +2620,16 @@ void draw_game()
   if((time-padup.pressed_time)<3000)
   {
     if(padup.button_pressed)
-      SDL_BlitSurface(padup.button_pressed,NULL,screen,&dest);
+      blit_layout(padup.button_pressed,&dest);
     dest.x=71;
     dest.y=89;
     if(info_padup)
-      SDL_BlitSurface(info_padup,NULL,screen,&dest);
+      blit_layout(info_padup,&dest);
   }
   else
   {
     if(padup.button)
-      SDL_BlitSurface(padup.button,NULL,screen,&dest);
+      blit_layout(padup.button,&dest);
   }
   // button down
   dest.x=paddown.x;
@@ -1509,16 +2637,16 @@ void draw_game()
   if((time-paddown.pressed_time)<3000)
   {
     if(paddown.button_pressed)
-      SDL_BlitSurface(paddown.button_pressed,NULL,screen,&dest);
+      blit_layout(paddown.button_pressed,&dest);
     dest.x=59;
     dest.y=115;
     if(info_paddown)
-      SDL_BlitSurface(info_paddown,NULL,screen,&dest);
+      blit_layout(info_paddown,&dest);
   }
   else
   {
     if(paddown.button)
-      SDL_BlitSurface(paddown.button,NULL,screen,&dest);
+      blit_layout(paddown.button,&dest);
   }
   // button left
   dest.x=padleft.x;
@@ -1526,16 +2654,16 @@ void draw_game()
   if((time-padleft.pressed_time)<3000)
   {
     if(padleft.button_pressed)
-      SDL_BlitSurface(padleft.button_pressed,NULL,screen,&dest);
+      blit_layout(padleft.button_pressed,&dest);
     dest.x=63;
     dest.y=98;
     if(info_padleft)
-      SDL_BlitSurface(info_padleft,NULL,screen,&dest);
+      blit_layout(info_padleft,&dest);
   }
   else
   {
     if(padleft.button)
-      SDL_BlitSurface(padleft.button,NULL,screen,&dest);
+      blit_layout(padleft.button,&dest);
   }
   // button right
   dest.x=padright.x;
@@ -1543,16 +2671,16 @@ void draw_game()
   if((time-padright.pressed_time)<3000)
   {
     if(padright.button_pressed)
-      SDL_BlitSurface(padright.button_pressed,NULL,screen,&dest);
+      blit_layout(padright.button_pressed,&dest);
     dest.x=58;
     dest.y=105;
     if(info_padright)
-      SDL_BlitSurface(info_padright,NULL,screen,&dest);
+      blit_layout(info_padright,&dest);
   }
   else
   {
     if(padright.button)
-      SDL_BlitSurface(padright.button,NULL,screen,&dest);
+      blit_layout(padright.button,&dest);
   }
   // button power
   dest.x=btnpw.x;
@@ -1560,16 +2688,16 @@ void draw_game()
   if((time-btnpw.pressed_time)<3000)
   {
     if(btnpw.button_pressed)
-      SDL_BlitSurface(btnpw.button_pressed,NULL,screen,&dest);
+      blit_layout(btnpw.button_pressed,&dest);
     dest.x=106;
     dest.y=129;
     if(info_power)
-      SDL_BlitSurface(info_power,NULL,screen,&dest);
+      blit_layout(info_power,&dest);
   }
   else
   {
     if(btnpw.button)
-      SDL_BlitSurface(btnpw.button,NULL,screen,&dest);
+      blit_layout(btnpw.button,&dest);
   }
   // button volup
   dest.x=btnvu.x;
@@ -1577,16 +2705,16 @@ void draw_game()
   if((time-btnvu.pressed_time)<3000)
   {
     if(btnvu.button_pressed)
-      SDL_BlitSurface(btnvu.button_pressed,NULL,screen,&dest);
+      blit_layout(btnvu.button_pressed,&dest);
     dest.x=184;
     dest.y=129;
     if(info_volup)
-      SDL_BlitSurface(info_volup,NULL,screen,&dest);
+      blit_layout(info_volup,&dest);
   }
   else
   {
     if(btnvu.button)
-      SDL_BlitSurface(btnvu.button,NULL,screen,&dest);
+      blit_layout(btnvu.button,&dest);
   }
   // button voldown
   dest.x=btnvd.x;
@@ -1594,16 +2722,16 @@ void draw_game()
   if((time-btnvd.pressed_time)<3000)
   {
     if(btnvd.button_pressed)
-      SDL_BlitSurface(btnvd.button_pressed,NULL,screen,&dest);
+      blit_layout(btnvd.button_pressed,&dest);
     dest.x=148;
     dest.y=129;
     if(info_voldown)
-      SDL_BlitSurface(info_voldown,NULL,screen,&dest);
+      blit_layout(info_voldown,&dest);
   }
   else
   {
     if(btnvd.button)
-      SDL_BlitSurface(btnvd.button,NULL,screen,&dest);
+      blit_layout(btnvd.button,&dest);
   }
   // button l1
   dest.x=btnl1.x;
@@ -1611,16 +2739,16 @@ void draw_game()
   if((time-btnl1.pressed_time)<3000)
   {
     if(btnl1.button_pressed)
-      SDL_BlitSurface(btnl1.button_pressed,NULL,screen,&dest);
+      blit_layout(btnl1.button_pressed,&dest);
     dest.x=86;
     dest.y=40;
     if(info_btnl1)
-      SDL_BlitSurface(info_btnl1,NULL,screen,&dest);
+      blit_layout(info_btnl1,&dest);
   }
   else
   {
     if(btnl1.button)
-      SDL_BlitSurface(btnl1.button,NULL,screen,&dest);
+      blit_layout(btnl1.button,&dest);
   }
   // button l2
   dest.x=btnl2.x;
@@ -1628,16 +2756,16 @@ void draw_game()
   if((time-btnl2.pressed_time)<3000)
   {
     if(btnl2.button_pressed)
-      SDL_BlitSurface(btnl2.button_pressed,NULL,screen,&dest);
+      blit_layout(btnl2.button_pressed,&dest);
     dest.x=109;
     dest.y=40;
     if(info_btnl2)
-      SDL_BlitSurface(info_btnl2,NULL,screen,&dest);
+      blit_layout(info_btnl2,&dest);
   }
   else
   {
     if(btnl2.button)
-      SDL_BlitSurface(btnl2.button,NULL,screen,&dest);
+      blit_layout(btnl2.button,&dest);
   }
   // button r1
   dest.x=btnr1.x;
@@ -1645,16 +2773,16 @@ void draw_game()
   if((time-btnr1.pressed_time)<3000)
   {
     if(btnr1.button_pressed)
-      SDL_BlitSurface(btnr1.button_pressed,NULL,screen,&dest);
+      blit_layout(btnr1.button_pressed,&dest);
     dest.x=213;
     dest.y=40;
     if(info_btnr1)
-      SDL_BlitSurface(info_btnr1,NULL,screen,&dest);
+      blit_layout(info_btnr1,&dest);
   }
   else
   {
     if(btnr1.button)
-      SDL_BlitSurface(btnr1.button,NULL,screen,&dest);
+      blit_layout(btnr1.button,&dest);
   }
   // button r2
   dest.x=btnr2.x;
@@ -1662,16 +2790,16 @@ void draw_game()
   if((time-btnr2.pressed_time)<3000)
   {
     if(btnr2.button_pressed)
-      SDL_BlitSurface(btnr2.button_pressed,NULL,screen,&dest);
+      blit_layout(btnr2.button_pressed,&dest);
     dest.x=200;
     dest.y=40;
     if(info_btnr2)
-      SDL_BlitSurface(info_btnr2,NULL,screen,&dest);
+      blit_layout(info_btnr2,&dest);
   }
   else
   {
     if(btnr2.button)
-      SDL_BlitSurface(btnr2.button,NULL,screen,&dest);
+      blit_layout(btnr2.button,&dest);
   }
   // button select
   dest.x=btnsel.x;
@@ -1679,16 +2807,16 @@ void draw_game()
   if((time-btnsel.pressed_time)<3000)
   {
     if(btnsel.button_pressed)
-      SDL_BlitSurface(btnsel.button_pressed,NULL,screen,&dest);
+      blit_layout(btnsel.button_pressed,&dest);
     dest.x=53;
     dest.y=52;
     if(info_select)
-      SDL_BlitSurface(info_select,NULL,screen,&dest);
+      blit_layout(info_select,&dest);
   }
   else
   {
     if(btnsel.button)
-      SDL_BlitSurface(btnsel.button,NULL,screen,&dest);
+      blit_layout(btnsel.button,&dest);
   }
   // button start
   dest.x=btnst.x;
@@ -1696,16 +2824,16 @@ void draw_game()
   if((time-btnst.pressed_time)<3000)
   {
     if(btnst.button_pressed)
-      SDL_BlitSurface(btnst.button_pressed,NULL,screen,&dest);
+      blit_layout(btnst.button_pressed,&dest);
     dest.x=206;
     dest.y=52;
     if(info_start)
-      SDL_BlitSurface(info_start,NULL,screen,&dest);
+      blit_layout(info_start,&dest);
   }
   else
   {
     if(btnst.button)
-      SDL_BlitSurface(btnst.button,NULL,screen,&dest);
+      blit_layout(btnst.button,&dest);
   }
 
   if(mouse_active)
@@ -1716,9 +2844,9 @@ void draw_game()
     dest.w=32;
     dest.h=10;
     if(mainmouse.button_left)
-      SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,192,192,0));
+      layout_fill(screen,&dest, SDL_MapRGB(screen->format,192,192,0));
     else
-      SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,64,64,0));
+      layout_fill(screen,&dest, SDL_MapRGB(screen->format,64,64,0));
 
     // draw right button
     dest.x=rg_x+37+34;
@@ -1726,9 +2854,9 @@ void draw_game()
     dest.w=32;
     dest.h=10;
     if(mainmouse.button_right)
-      SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,192,192,0));
+      layout_fill(screen,&dest, SDL_MapRGB(screen->format,192,192,0));
     else
-      SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,64,64,0));
+      layout_fill(screen,&dest, SDL_MapRGB(screen->format,64,64,0));
 
     // draw coordinates
     char mxval[5];
@@ -1742,8 +2870,8 @@ void draw_game()
     int posmx,posmy;
     posmx=mainmouse.x/5.5;
     posmy=mainmouse.y/5.8;
-    drawLine(screen,131-3+posmx,70+posmy,131+4+posmx,70+posmy,SDL_MapRGB(screen->format,255,255,255));
-    drawLine(screen,131+posmx,70-3+posmy,131+posmx,70+4+posmy,SDL_MapRGB(screen->format,255,255,255));
+    layout_hline(screen,131-3+posmx,131+3+posmx,70+posmy,SDL_MapRGB(screen->format,255,255,255));
+    layout_vline(screen,131+posmx,70-3+posmy,70+3+posmy,SDL_MapRGB(screen->format,255,255,255));
 
   }
   else
@@ -1759,12 +2887,16 @@ void draw_game()
     sprintf(j1yval,"%.2f",double(j1_y)/32767.0);
     draw_text(screen,j1yval,131,79,255,0,255);
 
+    // stick range rings, full and half range
+    layout_ellipse(screen,131+28,70+20,29,20,SDL_MapRGB(screen->format,96,96,96));
+    layout_ellipse(screen,131+28,70+20,14,10,SDL_MapRGB(screen->format,48,48,48));
+
     // draw cross
     int pos1x,pos1y;
     pos1x=(j1_x+32767)/1130;
     pos1y=(j1_y+32767)/1598;
-    drawLine(screen,131-3+pos1x,70+pos1y,131+4+pos1x,70+pos1y,SDL_MapRGB(screen->format,255,0,255));
-    drawLine(screen,131+pos1x,70-3+pos1y,131+pos1x,70+4+pos1y,SDL_MapRGB(screen->format,255,0,255));
+    layout_hline(screen,131-3+pos1x,131+3+pos1x,70+pos1y,SDL_MapRGB(screen->format,255,0,255));
+    layout_vline(screen,131+pos1x,70-3+pos1y,70+3+pos1y,SDL_MapRGB(screen->format,255,0,255));
 
     // joystick 2 range
     int j2_x,j2_y;
@@ -1781,15 +2913,15 @@ void draw_game()
     int pos2x,pos2y;
     pos2x=(j2_x+32767)/1130;
     pos2y=(j2_y+32767)/1598;
-    drawLine(screen,131-3+pos2x,70+pos2y,131+4+pos2x,70+pos2y,SDL_MapRGB(screen->format,0,255,255));
-    drawLine(screen,131+pos2x,70-3+pos2y,131+pos2x,70+4+pos2y,SDL_MapRGB(screen->format,0,255,255));
+    layout_hline(screen,131-3+pos2x,131+3+pos2x,70+pos2y,SDL_MapRGB(screen->format,0,255,255));
+    layout_vline(screen,131+pos2x,70-3+pos2y,70+3+pos2y,SDL_MapRGB(screen->format,0,255,255));
   }
 
   // cpu icon
   dest.x=rg_x+180;
   dest.y=rg_y-5;
   if(rg350_cpu)
-    SDL_BlitSurface(rg350_cpu,NULL,screen,&dest);
+    blit_layout(rg350_cpu,&dest);
   if(cpu_clock_value>1000)
     draw_text(screen,cpu_clock,dest.x+12-text_width(cpu_clock)/2,dest.y+23,64,192,64);
   else if(cpu_clock_value<1000)
@@ -1797,13 +2929,34 @@ void draw_game()
   else
     draw_text(screen,cpu_clock,dest.x+12-text_width(cpu_clock)/2,dest.y+23,255,255,255);
 
+  // cpu benchmark, score under the clock and every kernel below the battery
+  char bench_text[20];
+  if(bench_score>0)
+    sprintf(bench_text,"%i pts",bench_score);
+  else if(cpubench_done())
+    sprintf(bench_text,"n/a");
+  else
+    sprintf(bench_text,"...");
+  draw_text(screen,bench_text,dest.x+12-text_width(bench_text)/2,dest.y+31,192,192,192);
+  for(int f=0;f<BENCH_COUNT;f++)
+  {
+    if(bench_results[f].status!=2)
+      break;
+    // Mops/s when the clock is unknown
+    if(bench_results[f].per_mhz>0)
+      sprintf(bench_text,"%s %.2f",bench_names[f],bench_results[f].per_mhz);
+    else
+      sprintf(bench_text,"%s %.0fM",bench_names[f],bench_results[f].mops);
+    draw_text(screen,bench_text,258,142+f*9,128,128,128);
+  }
+
   // battery icon
   /*dest.x=rg_x+180;
   dest.y=rg_y+20;*/
   dest.x=rg_x+184;
   dest.y=rg_y+35;
   if(rg350_battery)
-    SDL_BlitSurface(rg350_battery,NULL,screen,&dest);
+    blit_layout(rg350_battery,&dest);
 
   if(!is_batterycharging())
   {
@@ -1823,22 +2976,30 @@ void draw_game()
   dest.y=dest.y+43-dest.h; // capacity rectangle is 38 pixels high
 
   if(battery_level>24)
-    SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,64,192,64));  // green power
+    layout_fill(screen,&dest, SDL_MapRGB(screen->format,64,192,64));  // green power
   else if(battery_level>0)
-      SDL_FillRect(screen, &dest, SDL_MapRGB(screen->format,192,64,64));  // red power
+      layout_fill(screen,&dest, SDL_MapRGB(screen->format,192,64,64));  // red power
 
   // if connected to usb, draw charging battery icon
   dest.x=rg_x+184;
   dest.y=rg_y+35;
   if(battery_charging)
     if(rg350_battery2)
-      SDL_BlitSurface(rg350_battery2,NULL,screen,&dest);
+      blit_layout(rg350_battery2,&dest);
 
   // info texts
+  if(stream_results.status==1)
+  {
+    char stream_text[60];
+    sprintf(stream_text,"music: cpu %.1f%%, buffer %.0f%%, %.2f MB/s",stream_results.cpu,stream_results.fill,stream_results.read_mbs);
+    draw_text(screen,stream_text,10,170,64,192,192);
+  }
   draw_text(screen, (char*)msg[0],10,180,255,255,0);
   draw_text(screen, (char*)msg[1],10,190,255,255,0);
+  draw_text(screen, (char*)synth_names[synth_mode()],14+text_width((char*)msg[1]),190,synth_playing()?64:128,synth_playing()?192:128,synth_playing()?64:128);
   draw_text(screen, (char*)msg[3],10,200,255,255,0);
   draw_text(screen, (char*)msg[4],10,210,255,255,0);
+  draw_text(screen, (char*)msg[6],10,220,255,255,0);
   if(view_author)
     draw_text(screen, (char*)author,10,230,255,0,255);
   draw_text(screen, (char*)version,300,230,69,69,69);
@@ -1858,12 +3019,12 @@ void draw_game()
   {
     case 1:
       if(sdcard_0)
-        SDL_BlitSurface(sdcard_0,NULL,screen,&dest);
+        blit_layout(sdcard_0,&dest);
       draw_text(screen,(char*)msg[5],120-text_width((char*)msg[5]),20,255,255,255);
       break;
     case 2:
       if(sdcard_1)
-        SDL_BlitSurface(sdcard_1,NULL,screen,&dest);
+        blit_layout(sdcard_1,&dest);
       if(sd_1.full==0)
         draw_text(screen,sd_1.free_text,120-text_width(sd_1.free_text)-text_width(sd_1.max_text)-text_width(sd_1.type),20,64,192,64);
       else if(sd_1.full==1)
@@ -1880,12 +3041,12 @@ void draw_game()
   {
     case 1:
       if(sdcard_0)
-        SDL_BlitSurface(sdcard_0,NULL,screen,&dest);
+        blit_layout(sdcard_0,&dest);
       draw_text(screen,(char*)msg[5],197,20,255,255,255);
       break;
     case 2:
       if(sdcard_2)
-        SDL_BlitSurface(sdcard_2,NULL,screen,&dest);
+        blit_layout(sdcard_2,&dest);
       if(sd_2.full==0)
         draw_text(screen,sd_2.free_text,197,20,64,192,64);
       else if(sd_2.full==1)
@@ -1900,18 +3061,18 @@ void draw_game()
 
   // speaker sound
   static Uint32 snd_ply=SDL_GetTicks();
-  if(Mix_Playing(-1)>0)
+  if(audio.opened && (Mix_Playing(-1)>0 || synth_playing() || stream_results.status==1))
   {
     if(SDL_GetTicks()-snd_ply>250)
     {
       dest.x=rg_x+15;
       dest.y=rg_y+78;
       if(speakersound_2)
-        SDL_BlitSurface(speakersound_2,NULL,screen,&dest);
+        blit_layout(speakersound_2,&dest);
       dest.x=rg_x+113;
       dest.y=rg_y+78;
       if(speakersound_2)
-        SDL_BlitSurface(speakersound_2,NULL,screen,&dest);
+        blit_layout(speakersound_2,&dest);
       if(SDL_GetTicks()-snd_ply>500)
         snd_ply=SDL_GetTicks();
     }
@@ -1920,11 +3081,11 @@ void draw_game()
       dest.x=rg_x+15;
       dest.y=rg_y+78;
       if(speakersound_1)
-        SDL_BlitSurface(speakersound_1,NULL,screen,&dest);
+        blit_layout(speakersound_1,&dest);
       dest.x=rg_x+113;
       dest.y=rg_y+78;
       if(speakersound_1)
-        SDL_BlitSurface(speakersound_1,NULL,screen,&dest);
+        blit_layout(speakersound_1,&dest);
     }
   }
 
@@ -1944,13 +3105,126 @@ void draw_game()
   }*/
 }
 
+///////////////////////////////////
+/*  Surface where the app draws  */
+/*  without the present thread   */
+///////////////////////////////////
+SDL_Surface* render_target()
+{
+  return postfx_source()?postfx_source():display;
+}
+
+///////////////////////////////////
+/*  Prepare postfx and layout    */
+/*  for the display. The app     */
+/*  draws 320x240 scaled 2x in   */
+/*  fullscreen, and with the     */
+/*  layout in the native mode    */
+///////////////////////////////////
+void set_rendertarget()
+{
+  int threaded=present_active();
+  present_stop();
+  postfx_setup(display,(fullscreen && !native_mode)?2:1,scanlines);
+  screen=render_target();
+  layout_set(screen->w,screen->h);
+  if(font)
+    load_font();
+  if(threaded)
+    present_start(display,screen->w,screen->h);
+}
+
+///////////////////////////////////
+/*  Set video mode of the app,   */
+/*  return 0 if no mode works    */
+///////////////////////////////////
+int set_videomode()
+{
+  int w=320,h=240;
+  if(native_mode)
+  {
+    w=native_w;
+    h=native_h;
+  }
+  else if(fullscreen)
+  {
+    w=640;
+    h=480;
+  }
+
+  int threaded=present_active();
+  present_stop();
+  postfx_end();
+  SDL_Surface* mode=SDL_SetVideoMode(w,h,SCREEN_BPP,SDL_HWSURFACE | SDL_DOUBLEBUF);
+  if(mode==NULL && (fullscreen || native_mode))
+  {
+    fullscreen=0;
+    native_mode=0;
+    mode=SDL_SetVideoMode(320,240,SCREEN_BPP,SDL_HWSURFACE | SDL_DOUBLEBUF);
+  }
+  if(mode==NULL)
+    return 0;
+  display=mode;
+  set_rendertarget();
+  if(threaded)
+    present_start(display,screen->w,screen->h);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Buttons held, one bit each   */
+/*  input of the factory test    */
+///////////////////////////////////
+Uint32 factory_inputs()
+{
+  const int held[FACTORY_BUTTONS]={
+    mainjoystick.pad_up,mainjoystick.pad_down,mainjoystick.pad_left,mainjoystick.pad_right,
+    mainjoystick.button_a,mainjoystick.button_b,mainjoystick.button_x,mainjoystick.button_y,
+    mainjoystick.button_l1,mainjoystick.button_l2,mainjoystick.button_r1,mainjoystick.button_r2,
+    mainjoystick.button_select,mainjoystick.button_start,mainjoystick.button_voldown,mainjoystick.button_volup,
+    mainjoystick.button_power,mainjoystick.button_l3,mainjoystick.button_r3
+  };
+  Uint32 inputs=0;
+  for(int f=0;f<FACTORY_BUTTONS;f++)
+    if(held[f])
+      inputs|=1<<f;
+  return inputs;
+}
+
+///////////////////////////////////
+/*  Ask a test that measures     */
+/*  time. The only core isn't    */
+/*  shared with rendering: it    */
+/*  runs after this frame, with  */
+/*  the loop stopped             */
+///////////////////////////////////
+void ask_test(int& status, void (*start)(), void (*wait)())
+{
+  if(status==1)
+    return;
+  status=1;   // the frame shows "running..."
+  test_start=start;
+  test_wait=wait;
+}
+
 ///////////////////////////////////
 /*  Check buttons, update actions*/
 ///////////////////////////////////
 void update_game()
 {
     static int active_sound=0;
+    static int active_soundmode=0;
     static int active_rumble=0;
+    static int active_screen=0;
+    static int active_start=0;
+    static int active_pacing=0;
+    static int active_profiler=0;
+    static int active_present=0;
+    static int active_pattern=0;
+    static int active_rumblepattern=0;
+    static int active_buildlut=0;
+    static int active_postfx=0;
+    static int active_native=0;
 
     clear_joystick_state();
     process_extrabuttons_events();
@@ -1960,14 +3234,225 @@ void update_game()
     // exit
     if(mainjoystick.button_l1 && mainjoystick.button_start)
         done=1;
-    // play sound
-    if(mainjoystick.button_l1 && mainjoystick.button_x && !active_sound)
+    // play sound, not while the audio test opens the mixer at other rates
+    if(mainjoystick.button_l1 && mainjoystick.button_x && !active_sound && audio_results.status!=1)
     {
         active_sound=1;
-        Mix_PlayChannel(1,sound_tone,0);
+        stream_stop();
+        if(synth_playing())
+          synth_stop();
+        else
+          synth_play(synth_mode());
     }
     if(!mainjoystick.button_l1 || !mainjoystick.button_x)
       active_sound=0;
+    // next test sound
+    if(mainjoystick.button_l1 && mainjoystick.button_y && !active_soundmode && audio_results.status!=1)
+    {
+        active_soundmode=1;
+        stream_stop();
+        synth_play((synth_mode()+1)%SYNTH_MODES);
+    }
+    if(!mainjoystick.button_l1 || !mainjoystick.button_y)
+      active_soundmode=0;
+    // change screen
+    if(mainjoystick.button_select && (mainjoystick.button_l1 || mainjoystick.button_r1) && !active_screen)
+    {
+        active_screen=1;
+        if(mainjoystick.button_r1)
+          app_screen=(app_screen+1)%SCREEN_COUNT;
+        else
+          app_screen=(app_screen+SCREEN_COUNT-1)%SCREEN_COUNT;
+        if(app_screen==SCREEN_PATTERN)
+          pattern_time=SDL_GetTicks();
+    }
+    if(!mainjoystick.button_select || (!mainjoystick.button_l1 && !mainjoystick.button_r1))
+      active_screen=0;
+    // flips of other screens aren't measured
+    if(app_screen!=SCREEN_VSYNC && vsync_results.status==1)
+      vsync_results.status=0;
+    // start the test of the screen
+    if(mainjoystick.button_a && !active_start)
+    {
+        active_start=1;
+        switch(app_screen)
+        {
+          case SCREEN_CPUFREQ:
+            ask_test(freq_sweep.status,cpufreq_sweep_start,cpufreq_sweep_wait);
+            break;
+          case SCREEN_MEMORY:
+            ask_test(mem_probe.status,memprobe_start,memprobe_wait);
+            break;
+          case SCREEN_RAMTEST:
+            if(ram_test.status==1)
+              ramtest_stop(ram_test);
+            else
+              ramtest_start(ram_test);
+            break;
+          case SCREEN_VIDEO:
+            video_results.status=1;   // runs next frame, after drawing "running..."
+            break;
+          case SCREEN_MODES:
+            mode_results.status=1;
+            break;
+          case SCREEN_VSYNC:
+            // flips are measured in the main thread
+            if(present_active())
+            {
+              present_stop();
+              screen=render_target();
+            }
+            vsynctest_start(vsync_results);
+            break;
+          case SCREEN_SLEEP:
+            ask_test(sleep_results.status,sleeptest_start,sleeptest_wait);
+            break;
+          case SCREEN_AUDIO:
+            // the mixer is opened again, the test sound stops
+            if(audio_results.status!=1)
+            {
+              synth_stop();
+              stream_stop();
+              audiodrift_stop(drift_results);
+              audiotest_start(audio_results);
+            }
+            break;
+          case SCREEN_DRIFT:
+            if(drift_results.status==1)
+              audiodrift_stop(drift_results);
+            else if(audio_results.status!=1)
+              audiodrift_start(drift_results);
+            break;
+          case SCREEN_RUMBLE:
+            rumble_play(rumble_selected);
+            break;
+          case SCREEN_FACTORY:
+            // A is an input of the test while it runs. Its sound step
+            // needs the mixer the audio test opens again
+            if(factory.status!=1 && audio_results.status!=1)
+            {
+              stream_stop();
+              factory_start(factory);
+            }
+            break;
+          case SCREEN_HISTORY:
+            save_report();
+            break;
+          case SCREEN_BATTERY:
+            if(battery.logging)
+              battery_logstop();
+            else
+              battery_logstart();
+            break;
+          case SCREEN_STREAM:
+            // music and the test sound use the same mixer hook
+            if(stream_results.status==1)
+              stream_stop();
+            else if(audio_results.status!=1)
+            {
+              synth_stop();
+              stream_start();
+            }
+            break;
+        }
+    }
+    if(!mainjoystick.button_a)
+      active_start=0;
+    // change frame pacing
+    if(app_screen==SCREEN_SLEEP && mainjoystick.button_b && !active_pacing)
+    {
+        active_pacing=1;
+        frame_pacing=!frame_pacing;
+    }
+    if(!mainjoystick.button_b)
+      active_pacing=0;
+    // change test pattern
+    if(app_screen==SCREEN_PATTERN && !mainjoystick.button_select && (mainjoystick.pad_left || mainjoystick.pad_right) && !active_pattern)
+    {
+        active_pattern=1;
+        if(mainjoystick.pad_right)
+          pattern_current=(pattern_current+1)%PATTERN_COUNT;
+        else
+          pattern_current=(pattern_current+PATTERN_COUNT-1)%PATTERN_COUNT;
+        pattern_time=SDL_GetTicks();
+    }
+    if(!mainjoystick.pad_left && !mainjoystick.pad_right)
+      active_pattern=0;
+    // change rumble pattern
+    if(app_screen==SCREEN_RUMBLE && !mainjoystick.button_select && (mainjoystick.pad_up || mainjoystick.pad_down) && !active_rumblepattern)
+    {
+        active_rumblepattern=1;
+        if(mainjoystick.pad_down)
+          rumble_selected=(rumble_selected+1)%RUMBLE_PATTERNS;
+        else
+          rumble_selected=(rumble_selected+RUMBLE_PATTERNS-1)%RUMBLE_PATTERNS;
+    }
+    if(!mainjoystick.pad_up && !mainjoystick.pad_down)
+      active_rumblepattern=0;
+    // table of the battery from the discharge logged
+    if(app_screen==SCREEN_BATTERY && mainjoystick.button_b && !active_buildlut)
+    {
+        active_buildlut=1;
+        battery_buildlut();
+    }
+    if(!mainjoystick.button_b)
+      active_buildlut=0;
+    // show profiler
+    if(mainjoystick.button_select && mainjoystick.button_x && !active_profiler)
+    {
+        active_profiler=1;
+        profiler_visible=!profiler_visible;
+    }
+    if(!mainjoystick.button_select || !mainjoystick.button_x)
+      active_profiler=0;
+    // flip in the main thread or in the present thread
+    if(mainjoystick.button_select && mainjoystick.button_y && !active_present && vsync_results.status!=1)
+    {
+        active_present=1;
+        if(present_active())
+        {
+          present_stop();
+          screen=render_target();
+        }
+        else
+          present_start(display,screen->w,screen->h);
+    }
+    if(!mainjoystick.button_select || !mainjoystick.button_y)
+      active_present=0;
+    // fullscreen and scanlines
+    if(mainjoystick.button_select && (mainjoystick.pad_up || mainjoystick.pad_down) && !active_postfx)
+    {
+        active_postfx=1;
+        if(mainjoystick.pad_up)
+        {
+          fullscreen=!fullscreen;
+          if(!set_videomode())
+          {
+            done=1;
+            return;
+          }
+        }
+        else
+        {
+          scanlines=!scanlines;
+          set_rendertarget();
+        }
+    }
+    if(!mainjoystick.button_select || (!mainjoystick.pad_up && !mainjoystick.pad_down))
+      active_postfx=0;
+    // draw at the resolution of the panel
+    if(mainjoystick.button_select && mainjoystick.pad_left && !active_native && (native_w!=320 || native_h!=240))
+    {
+        active_native=1;
+        native_mode=!native_mode;
+        if(!set_videomode())
+        {
+          done=1;
+          return;
+        }
+    }
+    if(!mainjoystick.button_select || !mainjoystick.pad_left)
+      active_native=0;
     // show author
     if(mainjoystick.button_select && mainjoystick.button_start)
         view_author=TRUE;
@@ -1975,7 +3460,7 @@ void update_game()
     if(mainjoystick.button_l2 && mainjoystick.button_r2 && !active_rumble)
     {
         active_rumble=1;
-        play_rumble();
+        rumble_play(RUMBLE_BUZZ);
     }
     if(!mainjoystick.button_l2 || !mainjoystick.button_r2)
       active_rumble=0;
@@ -2027,11 +3512,57 @@ void update_game()
     if(mainjoystick.j2_left<-GCW_JOYSTICK_DEADZONE || mainjoystick.j2_right>GCW_JOYSTICK_DEADZONE || mainjoystick.j2_down>GCW_JOYSTICK_DEADZONE || mainjoystick.j2_up<-GCW_JOYSTICK_DEADZONE)
         joy2.moved_time=SDL_GetTicks();
 
+    // guided factory test, only on its screen
+    int axes[4];
+    for(int f=0;f<4;f++)
+      axes[f]=SDL_JoystickGetAxis(joystick,f);
+    Uint32 inputs=factory_inputs();
+    report_track(inputs,axes);
+    if(app_screen!=SCREEN_FACTORY)
+      factory_stop(factory);
+    if(factory.status==1)
+    {
+      factory_update(factory,inputs,axes);
+      // report of the unit as soon as the test ends
+      if(factory.status==2)
+        save_report();
+    }
+
+    // video benchmark uses the whole cpu, it can't run in background
+    if(app_screen==SCREEN_VIDEO && video_results.status==1)
+      videobench_run(screen);
+    // video modes benchmark changes the mode, screen is a new surface
+    if(app_screen==SCREEN_MODES && mode_results.status==1)
+    {
+      // back buffers have the format of the old mode
+      int threaded=present_active();
+      present_stop();
+      display=modebench_run(display->w,display->h,SCREEN_BPP,SDL_HWSURFACE | SDL_DOUBLEBUF);
+      if(display==NULL)
+      {
+        done=1;
+        return;
+      }
+      set_rendertarget();
+      if(threaded)
+        present_start(display,screen->w,screen->h);
+    }
+
+    // audio test changes the config of the mixer every second
+    audiotest_step(audio_results);
+    audiodrift_step(drift_results);
+    stream_update();
+    rumble_update();
+
+    // RAM test runs half a frame every frame, so the app keeps working
+    if(app_screen==SCREEN_RAMTEST)
+      ramtest_step(ram_test,8000);
+
     // read battery and cpu every 2 seconds. Read it very fast can produce errors
     if(SDL_GetTicks()-battery_checktime>2000)
     {
         battery_charging=is_batterycharging();
-        battery_level=get_batterylevel();
+        battery_level=battery_read(battery_charging);
         battery_checktime=SDL_GetTicks();
         get_cpuclock();
     }
@@ -2045,12 +3576,18 @@ int main(int argc, char *argv[])
   if(SDL_Init(SDL_INIT_JOYSTICK | SDL_INIT_VIDEO | SDL_INIT_AUDIO)<0)
 		return 0;
 
-  screen = SDL_SetVideoMode(320, 240, 16, SDL_HWSURFACE | SDL_DOUBLEBUF);
-    if (screen==NULL)
-      return 0;
+  // RG350M and RG280M panels have more pixels, draw at their resolution
+  const SDL_VideoInfo* info=SDL_GetVideoInfo();
+  if(info && info->current_w>=320 && info->current_h>=240)
+  {
+    native_w=info->current_w;
+    native_h=info->current_h;
+    native_mode=(native_w!=320 || native_h!=240);
+  }
+  if(!set_videomode())
+    return 0;
 
   SDL_JoystickEventState(SDL_ENABLE);
-  Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, AUDIO_S16, MIX_DEFAULT_CHANNELS, 1024);
 
   sd_1.status=0;
   sd_2.status=0;
@@ -2058,24 +3595,100 @@ int main(int argc, char *argv[])
 
   init_game();
 
+  // single core: the benchmark runs with the first frame on screen and
+  // the loop stopped, so rendering isn't counted in the scores
+  draw_game();
+  if(screen!=display)
+    postfx_copy(screen,display);
+  SDL_Flip(display);
+  cpubench_wait();
+
   const int GAME_FPS=60;
   Uint32 start_time;
+  frame_pacer pacer;
+  unsigned long long rate_time=time_us();
+  int rate_frames=0;
+  unsigned long long frame_time=0;
+  unsigned long long input_time;
+
+  pacer_start(pacer,(1000000000L+GAME_FPS/2)/GAME_FPS);
 
   while(!done)
 	{
     start_time=SDL_GetTicks();
+    // with the present thread, wait the last frame is taken so input is sampled just before presenting
+    unsigned long long wait_time=time_us();
+    if(present_active())
+      screen=present_backbuffer();
+    input_time=time_us();
+    if(frame_time)
+      prof_record(PROF_FRAME,(unsigned int)(input_time-frame_time));
+    frame_time=input_time;
+
     update_game();
+    if(done)
+      break;
     draw_game();
+    if(profiler_visible)
+      draw_profiler();
+    unsigned long long present_time=time_us();
+    prof_record(PROF_RENDER,(unsigned int)(present_time-input_time));
+
+    if(present_active())
+    {
+      present_submit(input_time);
+      prof_record(PROF_PRESENT,(unsigned int)(time_us()-present_time+input_time-wait_time));
+    }
+    else
+    {
+      if(screen!=display)
+        postfx_copy(screen,display);
+      SDL_Flip(display);
+      prof_record(PROF_PRESENT,(unsigned int)(time_us()-present_time));
+      prof_record(PROF_LATENCY,(unsigned int)(time_us()-input_time));
+    }
 
-    SDL_Flip(screen);
+    // real frame rate, every second
+    rate_frames++;
+    if(time_us()-rate_time>=1000000)
+    {
+      loop_hz=rate_frames*1000000.0/(time_us()-rate_time);
+      rate_time=time_us();
+      rate_frames=0;
+    }
+
+    // test asked in this frame, the loop waits for it
+    if(test_start)
+    {
+      test_start();
+      test_wait();
+      test_start=NULL;
+      test_wait=NULL;
+      // the wait isn't a frame
+      rate_time=time_us();
+      rate_frames=0;
+      frame_time=0;
+      continue;
+    }
+
+    // vsync test needs the flips without frame limit
+    if(vsync_results.status==1)
+    {
+      vsynctest_flip(vsync_results,time_us());
+      continue;
+    }
 
     // set FPS 60
-    if(1000/GAME_FPS>SDL_GetTicks()-start_time)
+    if(frame_pacing)
+      pacer_wait(pacer);
+    else if(1000/GAME_FPS>SDL_GetTicks()-start_time)
       SDL_Delay(1000/GAME_FPS-(SDL_GetTicks()-start_time));
 	}
 
 	pthread_cancel(sd_th);
 	pthread_join(sd_th, NULL);
+  present_stop();
+  postfx_end();
   end_game();
   SDL_Quit();
 
@@ -0,0 +1,262 @@
+/*
+  RG350 Test
+  Memory hierarchy probe: line size from strided reads, cache sizes
+  from pointer chasing latency, and DRAM bandwidth.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "timing.h"
+#include "memprobe.h"
+
+#define MEMPROBE_BUFSIZE  (8*1024*1024)   // much bigger than the L2
+#define MEMPROBE_CHASES   (256*1024)      // pointer loads for every working set
+#define MEMPROBE_PASSES   8               // passes over the buffer in bandwidth tests
+#define MEMPROBE_MINLINE  16              // smallest node used in pointer chasing
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+memprobe_result mem_probe;
+
+static const int probe_sizes[MEMPROBE_SIZES]={
+2,3,4,6,8,12,16,24,32,48,64,96,128,192,256,384,512,768,1024,1536,2048,3072,4096,6144,8192
+};
+static unsigned char* probe_buffer=NULL;   // allocated once, reused in every run
+static unsigned int* probe_order=NULL;     // node order of the pointer chasing
+static pthread_t probe_th;
+static int probe_running=0;
+static volatile int probe_stop=0;
+volatile unsigned int probe_sink;
+
+///////////////////////////////////
+/*  Time per access reading the  */
+/*  buffer with a stride, in ns  */
+///////////////////////////////////
+static double probe_stride(int stride)
+{
+  unsigned int sum=0;
+  int accesses=0;
+
+  unsigned long long start=time_us();
+  for(int pass=0;pass<2;pass++)
+  {
+    for(int offset=0;offset<MEMPROBE_BUFSIZE;offset+=stride)
+      sum+=probe_buffer[offset];
+    accesses+=MEMPROBE_BUFSIZE/stride;
+  }
+  unsigned long long elapsed=time_us()-start;
+  probe_sink+=sum;
+  return elapsed*1000.0/accesses;
+}
+
+///////////////////////////////////
+/*  Line size: the cost of an    */
+/*  access stops growing when    */
+/*  every access is a miss       */
+///////////////////////////////////
+static int probe_linesize()
+{
+  double cost[7];
+  int stride,f;
+
+  for(f=0,stride=4;f<7;f++,stride*=2)
+    cost[f]=probe_stride(stride);
+  for(f=0,stride=4;f<7;f++,stride*=2)
+    if(cost[f]>=cost[6]*0.9)
+      return stride;
+  return 0;
+}
+
+///////////////////////////////////
+/*  Pointer chasing latency in a */
+/*  random cycle of lines, in ns */
+///////////////////////////////////
+static double probe_chase(int size, int line)
+{
+  int nodes=size/line;
+  unsigned int seed=12345;
+  int f;
+
+  // Sattolo's shuffle makes a single cycle through all the nodes
+  unsigned int* order=probe_order;
+  for(f=0;f<nodes;f++)
+    order[f]=f;
+  for(f=nodes-1;f>0;f--)
+  {
+    seed=seed*1103515245+12345;
+    int g=(seed>>8)%f;
+    unsigned int tmp=order[f];
+    order[f]=order[g];
+    order[g]=tmp;
+  }
+  for(f=0;f<nodes;f++)
+    *(void**)(probe_buffer+order[f]*line)=probe_buffer+order[(f+1)%nodes]*line;
+
+  // first lap loads the working set, second one is measured
+  void** p=(void**)probe_buffer;
+  for(f=0;f<nodes;f++)
+    p=(void**)*p;
+  unsigned long long start=time_us();
+  for(f=0;f<MEMPROBE_CHASES;f+=8)
+  {
+    p=(void**)*p; p=(void**)*p; p=(void**)*p; p=(void**)*p;
+    p=(void**)*p; p=(void**)*p; p=(void**)*p; p=(void**)*p;
+  }
+  unsigned long long elapsed=time_us()-start;
+  probe_sink+=(unsigned int)(size_t)p;
+  return elapsed*1000.0/MEMPROBE_CHASES;
+}
+
+///////////////////////////////////
+/*  Cache sizes: last working    */
+/*  set before a latency step    */
+///////////////////////////////////
+static void probe_caches(memprobe_result& result)
+{
+  int level=0;
+  double plateau=result.latency_ns[0];
+
+  for(int f=1;f<result.count && level<2;f++)
+  {
+    if(result.latency_ns[f]>plateau*1.4)
+    {
+      if(level==0)
+        result.l1_kb=result.size_kb[f-1];
+      else
+        result.l2_kb=result.size_kb[f-1];
+      level++;
+      plateau=result.latency_ns[f];
+    }
+    else if(result.latency_ns[f]>plateau)
+      plateau=result.latency_ns[f];
+  }
+}
+
+///////////////////////////////////
+/*  DRAM bandwidth, MB/s         */
+///////////////////////////////////
+static void probe_bandwidth(memprobe_result& result)
+{
+  unsigned int* words=(unsigned int*)probe_buffer;
+  const int count=MEMPROBE_BUFSIZE/sizeof(unsigned int);
+  unsigned int sum=0;
+  unsigned long long start,elapsed;
+  int pass,f;
+
+  start=time_us();
+  for(pass=0;pass<MEMPROBE_PASSES;pass++)
+    for(f=0;f<count;f+=4)
+      sum+=words[f]+words[f+1]+words[f+2]+words[f+3];
+  elapsed=time_us()-start;
+  probe_sink+=sum;
+  result.read_mbs=elapsed?(double)MEMPROBE_BUFSIZE*MEMPROBE_PASSES/elapsed:0;
+
+  start=time_us();
+  for(pass=0;pass<MEMPROBE_PASSES;pass++)
+    for(f=0;f<count;f+=4)
+    {
+      words[f]=pass;
+      words[f+1]=pass;
+      words[f+2]=pass;
+      words[f+3]=pass;
+    }
+  elapsed=time_us()-start;
+  result.write_mbs=elapsed?(double)MEMPROBE_BUFSIZE*MEMPROBE_PASSES/elapsed:0;
+
+  // copy half of the buffer over the other half, bytes copied
+  start=time_us();
+  for(pass=0;pass<MEMPROBE_PASSES;pass++)
+    memcpy(probe_buffer,probe_buffer+MEMPROBE_BUFSIZE/2,MEMPROBE_BUFSIZE/2);
+  elapsed=time_us()-start;
+  result.copy_mbs=elapsed?(double)MEMPROBE_BUFSIZE/2*MEMPROBE_PASSES/elapsed:0;
+}
+
+///////////////////////////////////
+/*  Thread that run the probe    */
+///////////////////////////////////
+static void* memprobe_thd(void* p)
+{
+  mem_probe.count=0;
+  mem_probe.l1_kb=0;
+  mem_probe.l2_kb=0;
+  memset(probe_buffer,0,MEMPROBE_BUFSIZE);
+
+  mem_probe.line_size=probe_linesize();
+  int line=mem_probe.line_size;
+  if(line<MEMPROBE_MINLINE)
+    line=MEMPROBE_MINLINE;
+
+  for(int f=0;f<MEMPROBE_SIZES && !probe_stop;f++)
+  {
+    mem_probe.size_kb[f]=probe_sizes[f];
+    mem_probe.latency_ns[f]=probe_chase(probe_sizes[f]*1024,line);
+    mem_probe.count++;
+  }
+  if(mem_probe.count>0)
+    mem_probe.random_ns=mem_probe.latency_ns[mem_probe.count-1];
+  probe_caches(mem_probe);
+
+  if(!probe_stop)
+    probe_bandwidth(mem_probe);
+  mem_probe.status=2;
+  return NULL;
+}
+
+///////////////////////////////////
+/*  Start probe in background    */
+///////////////////////////////////
+void memprobe_start()
+{
+  if(probe_running)
+    return;
+  mem_probe.status=0;
+  if(!probe_buffer && posix_memalign((void**)&probe_buffer,4096,MEMPROBE_BUFSIZE)!=0)
+  {
+    probe_buffer=NULL;
+    return;
+  }
+  if(!probe_order)
+    probe_order=(unsigned int*)malloc(MEMPROBE_BUFSIZE/MEMPROBE_MINLINE*sizeof(unsigned int));
+  if(!probe_order)
+    return;
+  probe_stop=0;
+  mem_probe.status=1;
+  if(pthread_create(&probe_th,NULL,memprobe_thd,NULL)==0)
+    probe_running=1;
+  else
+    mem_probe.status=0;
+}
+
+///////////////////////////////////
+/*  Wait for the probe to end    */
+///////////////////////////////////
+void memprobe_wait()
+{
+  if(!probe_running)
+    return;
+  pthread_join(probe_th,NULL);
+  probe_running=0;
+}
+
+///////////////////////////////////
+/*  Stop probe thread, free      */
+/*  buffers                      */
+///////////////////////////////////
+void memprobe_end()
+{
+  if(probe_running)
+  {
+    probe_stop=1;
+    pthread_join(probe_th,NULL);
+    probe_running=0;
+  }
+  free(probe_buffer);
+  free(probe_order);
+  probe_buffer=NULL;
+  probe_order=NULL;
+}
@@ -0,0 +1,42 @@
+/*
+  RG350 Test
+  Memory hierarchy probe: line size from strided reads, cache sizes
+  from pointer chasing latency, and DRAM bandwidth.
+*/
+
+#ifndef MEMPROBE_H
+#define MEMPROBE_H
+
+#define MEMPROBE_SIZES  25    // working sets from 2 KiB to 8 MiB
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct memprobe_result
+{
+  int status;                         // 0=not run, 1=running, 2=done
+  int count;                          // working sets measured
+  int size_kb[MEMPROBE_SIZES];
+  double latency_ns[MEMPROBE_SIZES];  // pointer chasing latency
+  int line_size;                      // bytes, 0 if unknown
+  int l1_kb;                          // 0 if no latency step found
+  int l2_kb;
+  double read_mbs;
+  double write_mbs;
+  double copy_mbs;
+  double random_ns;                   // latency of the biggest working set
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern memprobe_result mem_probe;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void memprobe_start();
+void memprobe_wait();
+void memprobe_end();
+
+#endif
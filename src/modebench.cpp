@@ -0,0 +1,191 @@
+/*
+  RG350 Test
+  Video mode benchmark: flip rate and CPU time per frame of every
+  candidate video mode, and with the IPU scaler options of the kernel
+  when they are found in sysfs.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include "timing.h"
+#include "modebench.h"
+
+#define MODEBENCH_TIME     500   // ms flipping every mode
+#define MODEBENCH_WARMUP   5     // flips before measuring
+
+#define IPU_KEEPASPECT     "/sys/devices/platform/jz-lcd.0/keep_aspect_ratio"
+#define IPU_SHARPNESS      "/sys/devices/platform/jz-lcd.0/sharpness_upscaling"
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct modebench_mode
+{
+  int w,h,bpp;
+  int doublebuf;
+};
+
+struct ipu_config
+{
+  int keep_aspect;    // -1=don't touch
+  int sharpness;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+mode_bench mode_results;
+
+static const modebench_mode modebench_modes[]={
+  {320,240,16,1},
+  {320,240,16,0},
+  {320,240,32,1},
+  {320,240,32,0},
+  {640,480,16,1},
+  {640,480,16,0},
+  {640,480,32,1},
+  {640,480,32,0}
+};
+#define MODEBENCH_MODES  (int)(sizeof(modebench_modes)/sizeof(modebench_modes[0]))
+
+///////////////////////////////////
+/*  Read a sysfs value, -1 if it */
+/*  doesn't exist                */
+///////////////////////////////////
+static int ipu_read(const char* path)
+{
+  int value=-1;
+  FILE* fd=fopen(path,"r");
+  if(!fd)
+    return -1;
+  if(fscanf(fd,"%d",&value)!=1)
+    value=-1;
+  fclose(fd);
+  return value;
+}
+
+///////////////////////////////////
+/*  Write a sysfs value          */
+///////////////////////////////////
+static int ipu_write(const char* path, int value)
+{
+  if(value<0)
+    return 0;
+  FILE* fd=fopen(path,"w");
+  if(!fd)
+    return 0;
+  int ok=fprintf(fd,"%d",value)>0;
+  if(fclose(fd)!=0)
+    ok=0;
+  return ok;
+}
+
+///////////////////////////////////
+/*  Flip the mode until time is  */
+/*  over                         */
+///////////////////////////////////
+static void modebench_measure(SDL_Surface* surface, modebench_row& row)
+{
+  Uint32 back=SDL_MapRGB(surface->format,16,16,16);
+  Uint32 color=SDL_MapRGB(surface->format,255,255,255);
+  SDL_Rect bar;
+  bar.y=0;
+  bar.w=surface->w/20;
+  bar.h=surface->h;
+
+  int frames=0;
+  unsigned long long start=0,cpu_start=0;
+  unsigned long long elapsed=0;
+  while(elapsed<MODEBENCH_TIME*1000)
+  {
+    // keep SDL and the input alive, the test is blocking
+    SDL_PumpEvents();
+    SDL_FillRect(surface,NULL,back);
+    bar.x=(frames*4)%(surface->w-bar.w);
+    SDL_FillRect(surface,&bar,color);
+    SDL_Flip(surface);
+    frames++;
+    if(frames==MODEBENCH_WARMUP)
+    {
+      start=time_us();
+      cpu_start=threadtime_us();
+      frames=0;
+    }
+    if(start)
+      elapsed=time_us()-start;
+  }
+  row.fps=frames*1000000.0/elapsed;
+  row.cpu_ms=frames?(threadtime_us()-cpu_start)/1000.0/frames:0;
+}
+
+///////////////////////////////////
+/*  Run all modes and set the    */
+/*  mode of the app again.       */
+/*  Return the new screen        */
+///////////////////////////////////
+SDL_Surface* modebench_run(int w, int h, int bpp, Uint32 flags)
+{
+  ipu_config configs[3];
+  int config_count=0;
+  int keep_aspect=ipu_read(IPU_KEEPASPECT);
+  int sharpness=ipu_read(IPU_SHARPNESS);
+
+  // options as found, then every option changed alone
+  configs[config_count].keep_aspect=keep_aspect;
+  configs[config_count].sharpness=sharpness;
+  config_count++;
+  if(keep_aspect>=0)
+  {
+    configs[config_count].keep_aspect=!keep_aspect;
+    configs[config_count].sharpness=sharpness;
+    config_count++;
+  }
+  if(sharpness>=0)
+  {
+    configs[config_count].keep_aspect=keep_aspect;
+    configs[config_count].sharpness=sharpness?0:8;
+    config_count++;
+  }
+
+  mode_results.count=0;
+  for(int f=0;f<MODEBENCH_MODES;f++)
+  {
+    const modebench_mode& mode=modebench_modes[f];
+    for(int c=0;c<config_count && mode_results.count<MODEBENCH_MAX;c++)
+    {
+      modebench_row& row=mode_results.rows[mode_results.count++];
+      row.w=mode.w;
+      row.h=mode.h;
+      row.bpp=mode.bpp;
+      row.doublebuf=mode.doublebuf;
+      row.got_doublebuf=0;
+      row.fps=0;
+      row.cpu_ms=0;
+      if(configs[c].keep_aspect<0 && configs[c].sharpness<0)
+        snprintf(row.ipu,sizeof(row.ipu),"-");
+      else
+      {
+        snprintf(row.ipu,sizeof(row.ipu),"a%d s%d",configs[c].keep_aspect,configs[c].sharpness);
+        // the scaler takes the options when the mode is set
+        if(!ipu_write(IPU_KEEPASPECT,configs[c].keep_aspect) && configs[c].keep_aspect>=0)
+          snprintf(row.ipu,sizeof(row.ipu),"read only");
+        if(!ipu_write(IPU_SHARPNESS,configs[c].sharpness) && configs[c].sharpness>=0)
+          snprintf(row.ipu,sizeof(row.ipu),"read only");
+      }
+
+      SDL_Surface* surface=SDL_SetVideoMode(mode.w,mode.h,mode.bpp,SDL_HWSURFACE | (mode.doublebuf?SDL_DOUBLEBUF:0));
+      row.ok=surface && surface->format->BitsPerPixel==mode.bpp;
+      if(!row.ok)
+        continue;
+      row.got_doublebuf=(surface->flags & SDL_DOUBLEBUF)!=0;
+      modebench_measure(surface,row);
+    }
+  }
+
+  ipu_write(IPU_KEEPASPECT,keep_aspect);
+  ipu_write(IPU_SHARPNESS,sharpness);
+  mode_results.status=2;
+  return SDL_SetVideoMode(w,h,bpp,flags);
+}
@@ -0,0 +1,49 @@
+/*
+  RG350 Test
+  Video mode benchmark: flip rate and CPU time per frame of every
+  candidate video mode, and with the IPU scaler options of the kernel
+  when they are found in sysfs.
+*/
+
+#ifndef MODEBENCH_H
+#define MODEBENCH_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define MODEBENCH_MAX  24
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct modebench_row
+{
+  int w,h,bpp;
+  int doublebuf;      // requested
+  int got_doublebuf;  // given by SDL
+  char ipu[32];       // scaler options, "-" if not found
+  int ok;             // 0=mode not available
+  double fps;         // flips per second, without frame limit
+  double cpu_ms;      // CPU time per frame of the drawing thread
+};
+
+struct mode_bench
+{
+  int status;         // 0=not run, 1=waiting to run, 2=done
+  int count;
+  modebench_row rows[MODEBENCH_MAX];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern mode_bench mode_results;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+SDL_Surface* modebench_run(int w, int h, int bpp, Uint32 flags);
+
+#endif
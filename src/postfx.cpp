@@ -0,0 +1,195 @@
+/*
+  RG350 Test
+  Post-processing from the 320x240 render buffer to the display: integer
+  scale and scanlines. Only rows changed since the last frame are
+  processed, once for every buffer of the display.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "timing.h"
+#include "profiler.h"
+#include "postfx.h"
+
+#define POSTFX_HALF16  0x7BEF7BEF   // two RGB565 pixels shifted right, without the bits of the next channel
+#define POSTFX_HALF32  0x7F7F7F7F
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+static SDL_Surface* postfx_src=NULL;   // render buffer when the app doesn't draw on the display
+static Uint8* postfx_shadow=NULL;      // source rows of the last frame
+static Uint8* postfx_pending=NULL;     // display buffers without the current row
+static int postfx_scale=1;
+static int postfx_scanlines=0;
+static int postfx_buffers=1;
+static int postfx_active=0;
+
+///////////////////////////////////
+/*  Copy a row darkened, two     */
+/*  RGB565 pixels every word     */
+///////////////////////////////////
+static void postfx_darken(Uint32* dst, const Uint32* src, int words, Uint32 mask)
+{
+  for(int f=0;f<words;f++)
+    dst[f]=(src[f]>>1)&mask;
+}
+
+///////////////////////////////////
+/*  Scale a row 2x, every pixel  */
+/*  is a word with two pixels    */
+///////////////////////////////////
+static void postfx_double16(Uint32* dst, const Uint16* src, int pixels)
+{
+  for(int f=0;f<pixels;f++)
+  {
+    Uint32 pixel=src[f];
+    dst[f]=pixel | pixel<<16;
+  }
+}
+
+///////////////////////////////////
+/*  Scale a row 2x, 32 bpp       */
+///////////////////////////////////
+static void postfx_double32(Uint32* dst, const Uint32* src, int pixels)
+{
+  for(int f=0;f<pixels;f++)
+  {
+    dst[f*2]=src[f];
+    dst[f*2+1]=src[f];
+  }
+}
+
+///////////////////////////////////
+/*  Write a source row in the    */
+/*  display rows                 */
+///////////////////////////////////
+static void postfx_row(SDL_Surface* src, SDL_Surface* display, int y)
+{
+  int bpp=display->format->BytesPerPixel;
+  Uint8* in=(Uint8*)src->pixels+y*src->pitch;
+  Uint8* out=(Uint8*)display->pixels+y*postfx_scale*display->pitch;
+  int bytes=display->w*bpp;
+  Uint32 mask=(bpp==2)?POSTFX_HALF16:POSTFX_HALF32;
+
+  if(postfx_scale==1)
+  {
+    // odd rows darkened, the pitch of the display can differ
+    if(postfx_scanlines && (y&1))
+      postfx_darken((Uint32*)out,(Uint32*)in,bytes/4,mask);
+    else
+      memcpy(out,in,bytes);
+    return;
+  }
+
+  if(bpp==2)
+    postfx_double16((Uint32*)out,(Uint16*)in,src->w);
+  else
+    postfx_double32((Uint32*)out,(Uint32*)in,src->w);
+  for(int f=1;f<postfx_scale;f++)
+  {
+    Uint8* line=out+f*display->pitch;
+    if(postfx_scanlines && f==postfx_scale-1)
+      postfx_darken((Uint32*)line,(Uint32*)out,bytes/4,mask);
+    else
+      memcpy(line,out,bytes);
+  }
+}
+
+///////////////////////////////////
+/*  Prepare buffers for a        */
+/*  display, return 0 if there   */
+/*  is no memory                 */
+///////////////////////////////////
+int postfx_setup(SDL_Surface* display, int scale, int scanlines)
+{
+  postfx_end();
+  postfx_scale=scale<1?1:scale;
+  postfx_scanlines=scanlines;
+  if(postfx_scale==1 && !postfx_scanlines)
+    return 1;
+
+  SDL_PixelFormat* format=display->format;
+  int w=display->w/postfx_scale;
+  int h=display->h/postfx_scale;
+  postfx_buffers=(display->flags & SDL_DOUBLEBUF)?2:1;
+  postfx_src=SDL_CreateRGBSurface(SDL_SWSURFACE,w,h,format->BitsPerPixel,format->Rmask,format->Gmask,format->Bmask,0);
+  postfx_shadow=(Uint8*)malloc(w*h*format->BytesPerPixel);
+  postfx_pending=(Uint8*)malloc(h);
+  if(!postfx_src || !postfx_shadow || !postfx_pending)
+  {
+    postfx_end();
+    postfx_scale=1;
+    postfx_scanlines=0;
+    return 0;
+  }
+  // every row of every buffer must be written the first time
+  memset(postfx_shadow,0,w*h*format->BytesPerPixel);
+  memset(postfx_pending,postfx_buffers,h);
+  postfx_active=1;
+  return 1;
+}
+
+///////////////////////////////////
+/*  Surface to draw, NULL if the */
+/*  app can draw on the display  */
+///////////////////////////////////
+SDL_Surface* postfx_source()
+{
+  return postfx_src;
+}
+
+///////////////////////////////////
+/*  Copy the render buffer to    */
+/*  the display back buffer      */
+///////////////////////////////////
+void postfx_copy(SDL_Surface* src, SDL_Surface* display)
+{
+  if(!postfx_active)
+  {
+    if(src!=display)
+      SDL_BlitSurface(src,NULL,display,NULL);
+    return;
+  }
+
+  unsigned long long start=time_us();
+  int row_bytes=src->w*src->format->BytesPerPixel;
+  if(SDL_MUSTLOCK(display) && SDL_LockSurface(display)<0)
+    return;
+  for(int y=0;y<src->h;y++)
+  {
+    Uint8* row=(Uint8*)src->pixels+y*src->pitch;
+    Uint8* shadow=postfx_shadow+y*row_bytes;
+    if(memcmp(row,shadow,row_bytes)!=0)
+    {
+      memcpy(shadow,row,row_bytes);
+      postfx_pending[y]=postfx_buffers;
+    }
+    if(postfx_pending[y])
+    {
+      postfx_row(src,display,y);
+      postfx_pending[y]--;
+    }
+  }
+  if(SDL_MUSTLOCK(display))
+    SDL_UnlockSurface(display);
+  prof_record(PROF_POSTFX,(unsigned int)(time_us()-start));
+}
+
+///////////////////////////////////
+/*  Free buffers                 */
+///////////////////////////////////
+void postfx_end()
+{
+  if(postfx_src)
+    SDL_FreeSurface(postfx_src);
+  free(postfx_shadow);
+  free(postfx_pending);
+  postfx_src=NULL;
+  postfx_shadow=NULL;
+  postfx_pending=NULL;
+  postfx_active=0;
+}
@@ -0,0 +1,24 @@
+/*
+  RG350 Test
+  Post-processing from the 320x240 render buffer to the display: integer
+  scale and scanlines. Only rows changed since the last frame are
+  processed, once for every buffer of the display.
+*/
+
+#ifndef POSTFX_H
+#define POSTFX_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+int postfx_setup(SDL_Surface* display, int scale, int scanlines);
+SDL_Surface* postfx_source();
+void postfx_copy(SDL_Surface* src, SDL_Surface* display);
+void postfx_end();
+
+#endif
@@ -0,0 +1,154 @@
+/*
+  RG350 Test
+  Present thread: the main thread draws into a back buffer and the
+  thread copies it to the display and flips, so the main thread isn't
+  blocked waiting the vertical blank. Two back buffers are handed off,
+  one drawn while the other is presented.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <pthread.h>
+#include "timing.h"
+#include "profiler.h"
+#include "postfx.h"
+#include "present.h"
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+static SDL_Surface* present_display=NULL;
+static SDL_Surface* present_slots[2];
+static unsigned long long present_input[2];  // time the input of every slot was sampled
+static int present_render=0;        // slot drawn by the main thread
+static int present_pending=-1;      // slot waiting to be presented
+static int present_copying=-1;      // slot being copied to the display
+static int present_quit=0;
+static pthread_t present_th;
+static pthread_mutex_t present_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t present_cond=PTHREAD_COND_INITIALIZER;
+
+///////////////////////////////////
+/*  Thread that presents slots   */
+///////////////////////////////////
+static void* present_thd(void* p)
+{
+  for(;;)
+  {
+    pthread_mutex_lock(&present_mutex);
+    while(present_pending<0 && !present_quit)
+      pthread_cond_wait(&present_cond,&present_mutex);
+    if(present_quit)
+    {
+      pthread_mutex_unlock(&present_mutex);
+      break;
+    }
+    int slot=present_pending;
+    present_pending=-1;
+    present_copying=slot;
+    // main thread can draw the next frame now
+    pthread_cond_broadcast(&present_cond);
+    pthread_mutex_unlock(&present_mutex);
+
+    postfx_copy(present_slots[slot],present_display);
+    unsigned long long input_time=present_input[slot];
+
+    pthread_mutex_lock(&present_mutex);
+    present_copying=-1;
+    pthread_cond_broadcast(&present_cond);
+    pthread_mutex_unlock(&present_mutex);
+
+    SDL_Flip(present_display);
+    prof_record(PROF_LATENCY,(unsigned int)(time_us()-input_time));
+  }
+  return NULL;
+}
+
+///////////////////////////////////
+/*  Create back buffers with the */
+/*  format of the display and    */
+/*  start thread                 */
+///////////////////////////////////
+int present_start(SDL_Surface* display, int w, int h)
+{
+  if(present_display || !display)
+    return 0;
+  SDL_PixelFormat* format=display->format;
+  for(int f=0;f<2;f++)
+  {
+    present_slots[f]=SDL_CreateRGBSurface(SDL_SWSURFACE,w,h,format->BitsPerPixel,format->Rmask,format->Gmask,format->Bmask,0);
+    if(!present_slots[f])
+    {
+      if(f==1)
+        SDL_FreeSurface(present_slots[0]);
+      return 0;
+    }
+  }
+  present_display=display;
+  present_render=0;
+  present_pending=-1;
+  present_copying=-1;
+  present_quit=0;
+  if(pthread_create(&present_th,NULL,present_thd,NULL)!=0)
+  {
+    SDL_FreeSurface(present_slots[0]);
+    SDL_FreeSurface(present_slots[1]);
+    present_display=NULL;
+    return 0;
+  }
+  return 1;
+}
+
+///////////////////////////////////
+/*  Stop thread, free buffers    */
+///////////////////////////////////
+void present_stop()
+{
+  if(!present_display)
+    return;
+  pthread_mutex_lock(&present_mutex);
+  present_quit=1;
+  pthread_cond_broadcast(&present_cond);
+  pthread_mutex_unlock(&present_mutex);
+  pthread_join(present_th,NULL);
+  SDL_FreeSurface(present_slots[0]);
+  SDL_FreeSurface(present_slots[1]);
+  present_display=NULL;
+}
+
+///////////////////////////////////
+/*  Is the thread presenting     */
+///////////////////////////////////
+int present_active()
+{
+  return present_display!=NULL;
+}
+
+///////////////////////////////////
+/*  Wait until the last frame is */
+/*  taken by the thread, return  */
+/*  the buffer to draw           */
+///////////////////////////////////
+SDL_Surface* present_backbuffer()
+{
+  pthread_mutex_lock(&present_mutex);
+  while((present_pending>=0 || present_copying==present_render) && !present_quit)
+    pthread_cond_wait(&present_cond,&present_mutex);
+  pthread_mutex_unlock(&present_mutex);
+  return present_slots[present_render];
+}
+
+///////////////////////////////////
+/*  Hand off the drawn buffer    */
+///////////////////////////////////
+void present_submit(unsigned long long input_time)
+{
+  pthread_mutex_lock(&present_mutex);
+  present_input[present_render]=input_time;
+  present_pending=present_render;
+  present_render=!present_render;
+  pthread_cond_broadcast(&present_cond);
+  pthread_mutex_unlock(&present_mutex);
+}
+
@@ -0,0 +1,26 @@
+/*
+  RG350 Test
+  Present thread: the main thread draws into a back buffer and the
+  thread copies it to the display and flips, so the main thread isn't
+  blocked waiting the vertical blank. Two back buffers are handed off,
+  one drawn while the other is presented.
+*/
+
+#ifndef PRESENT_H
+#define PRESENT_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+int present_start(SDL_Surface* display, int w, int h);
+void present_stop();
+int present_active();
+SDL_Surface* present_backbuffer();
+void present_submit(unsigned long long input_time);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+  RG350 Test
+  Frame profiler: the last times of every counter, shown over any screen
+  with the average and the maximum.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include "profiler.h"
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+const char* prof_names[PROF_COUNTERS]={"frame","render","present","latency","postfx","fft"};
+static prof_counter prof_counters[PROF_COUNTERS];
+
+///////////////////////////////////
+/*  Save a time                  */
+///////////////////////////////////
+void prof_record(int counter, unsigned int us)
+{
+  prof_counter& current=prof_counters[counter];
+  current.samples[current.next]=us;
+  current.next=(current.next+1)%PROF_SAMPLES;
+  if(current.count<PROF_SAMPLES)
+    current.count++;
+}
+
+///////////////////////////////////
+/*  Average and max of the last  */
+/*  times, return 0 if empty     */
+///////////////////////////////////
+int prof_stats(int counter, unsigned int& average, unsigned int& max)
+{
+  prof_counter& current=prof_counters[counter];
+  unsigned long long total=0;
+  average=0;
+  max=0;
+  if(current.count==0)
+    return 0;
+  for(int f=0;f<current.count;f++)
+  {
+    total+=current.samples[f];
+    if(current.samples[f]>max)
+      max=current.samples[f];
+  }
+  average=(unsigned int)(total/current.count);
+  return 1;
+}
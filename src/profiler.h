@@ -0,0 +1,41 @@
+/*
+  RG350 Test
+  Frame profiler: the last times of every counter, shown over any screen
+  with the average and the maximum.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#define PROF_FRAME      0   // time between frames
+#define PROF_RENDER     1   // input and drawing
+#define PROF_PRESENT    2   // main thread blocked by the flip or the handoff
+#define PROF_LATENCY    3   // input sampled to flip returned
+#define PROF_POSTFX     4   // scale and scanlines
+#define PROF_FFT        5   // spectrum of the audio scope
+#define PROF_COUNTERS   6
+
+#define PROF_SAMPLES    60
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct prof_counter
+{
+  unsigned int samples[PROF_SAMPLES];   // us
+  int next;
+  int count;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern const char* prof_names[PROF_COUNTERS];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void prof_record(int counter, unsigned int us);
+int prof_stats(int counter, unsigned int& average, unsigned int& max);
+
+#endif
@@ -0,0 +1,262 @@
+/*
+  RG350 Test
+  RAM test with memtest patterns. The test runs in small steps from the
+  main loop, so the screen and the buttons keep working.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timing.h"
+#include "ramtest.h"
+
+#define RAMTEST_CHUNK    (16*1024)          // words tested between time checks
+#define RAMTEST_RESERVE  (16*1024*1024)     // bytes left free for the system
+#define RAMTEST_MINSIZE  (1024*1024)
+
+#define OP_FILL_WALK   0   // word i = pattern rotated i bits
+#define OP_CHECK_WALK  1
+#define OP_FILL        2   // every word = pattern
+#define OP_CHECK_INV   3   // check pattern and write inverted pattern
+#define OP_CHECK       4
+#define OP_FILL_ADDR   5   // every word = its own address
+#define OP_CHECK_ADDR  6
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct ramtest_phase
+{
+  int op;
+  int down;               // 1=from last word to first one
+  unsigned int pattern;
+  const char* name;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+ramtest_state ram_test;
+
+static const ramtest_phase ramtest_phases[]={
+{OP_FILL_WALK,  0,0x00000001,"walking ones"},
+{OP_CHECK_WALK, 0,0x00000001,"walking ones"},
+{OP_FILL_WALK,  0,0xFFFFFFFE,"walking zeros"},
+{OP_CHECK_WALK, 0,0xFFFFFFFE,"walking zeros"},
+{OP_FILL,       0,0x55555555,"moving inversions"},
+{OP_CHECK_INV,  0,0x55555555,"moving inversions"},
+{OP_CHECK_INV,  1,0xAAAAAAAA,"moving inversions"},
+{OP_CHECK,      0,0x55555555,"moving inversions"},
+{OP_FILL_ADDR,  0,0,"address in address"},
+{OP_CHECK_ADDR, 0,0,"address in address"}
+};
+#define RAMTEST_PHASES  (int)(sizeof(ramtest_phases)/sizeof(ramtest_phase))
+
+///////////////////////////////////
+/*  Free memory in the system,   */
+/*  bytes                        */
+///////////////////////////////////
+static unsigned long ramtest_available()
+{
+  char line[128];
+  unsigned long value;
+  unsigned long available=0,free_kb=0,buffers=0,cached=0;
+
+  FILE* meminfo=fopen("/proc/meminfo","r");
+  if(!meminfo)
+    return 0;
+  while(fgets(line,sizeof(line),meminfo))
+  {
+    if(sscanf(line,"MemAvailable: %lu",&value)==1)
+      available=value;
+    else if(sscanf(line,"MemFree: %lu",&value)==1)
+      free_kb=value;
+    else if(sscanf(line,"Buffers: %lu",&value)==1)
+      buffers=value;
+    else if(sscanf(line,"Cached: %lu",&value)==1)
+      cached=value;
+  }
+  fclose(meminfo);
+
+  // old kernels don't have MemAvailable
+  if(available==0)
+    available=free_kb+buffers+cached;
+  return available*1024;
+}
+
+///////////////////////////////////
+/*  Save a failing word          */
+///////////////////////////////////
+static void ramtest_fail(ramtest_state& test, unsigned int* word, unsigned int expected)
+{
+  if(test.error_count<RAMTEST_MAXERRORS)
+  {
+    ramtest_error& error=test.errors[test.error_count];
+    error.address=(unsigned long)word;
+    error.expected=expected;
+    error.bits=*word ^ expected;
+  }
+  test.error_count++;
+}
+
+///////////////////////////////////
+/*  Run a phase on some words    */
+///////////////////////////////////
+static void ramtest_chunk(ramtest_state& test, const ramtest_phase& phase, unsigned int first, unsigned int count)
+{
+  unsigned int* words=test.buffer+first;
+  unsigned int pattern=phase.pattern;
+  unsigned int f;
+
+  switch(phase.op)
+  {
+    case OP_FILL_WALK:
+      for(f=0;f<count;f++)
+      {
+        unsigned int shift=(first+f) & 31;
+        words[f]=(pattern<<shift) | (pattern>>((32-shift) & 31));
+      }
+      break;
+    case OP_CHECK_WALK:
+      for(f=0;f<count;f++)
+      {
+        unsigned int shift=(first+f) & 31;
+        unsigned int expected=(pattern<<shift) | (pattern>>((32-shift) & 31));
+        if(words[f]!=expected)
+          ramtest_fail(test,&words[f],expected);
+      }
+      break;
+    case OP_FILL:
+      for(f=0;f<count;f++)
+        words[f]=pattern;
+      break;
+    case OP_CHECK_INV:
+      if(phase.down)
+      {
+        for(f=count;f>0;f--)
+        {
+          if(words[f-1]!=pattern)
+            ramtest_fail(test,&words[f-1],pattern);
+          words[f-1]=~pattern;
+        }
+      }
+      else
+      {
+        for(f=0;f<count;f++)
+        {
+          if(words[f]!=pattern)
+            ramtest_fail(test,&words[f],pattern);
+          words[f]=~pattern;
+        }
+      }
+      break;
+    case OP_CHECK:
+      for(f=0;f<count;f++)
+        if(words[f]!=pattern)
+          ramtest_fail(test,&words[f],pattern);
+      break;
+    case OP_FILL_ADDR:
+      for(f=0;f<count;f++)
+        words[f]=(unsigned int)(unsigned long)&words[f];
+      break;
+    case OP_CHECK_ADDR:
+      for(f=0;f<count;f++)
+        if(words[f]!=(unsigned int)(unsigned long)&words[f])
+          ramtest_fail(test,&words[f],(unsigned int)(unsigned long)&words[f]);
+      break;
+  }
+}
+
+///////////////////////////////////
+/*  Allocate memory and start    */
+///////////////////////////////////
+void ramtest_start(ramtest_state& test)
+{
+  ramtest_stop(test);
+
+  // 3/4 of the free memory, the rest is left for the system and the app
+  unsigned long size=ramtest_available()/4*3;
+  if(size>RAMTEST_RESERVE+RAMTEST_MINSIZE)
+    size-=RAMTEST_RESERVE;
+  else
+    size=RAMTEST_MINSIZE;
+  while(size>=RAMTEST_MINSIZE && !test.buffer)
+  {
+    test.buffer=(unsigned int*)malloc(size);
+    if(!test.buffer)
+      size/=2;
+  }
+  if(!test.buffer)
+  {
+    test.status=2;
+    return;
+  }
+
+  test.words=size/sizeof(unsigned int);
+  test.phase=0;
+  test.offset=0;
+  test.passes=0;
+  test.bytes=0;
+  test.time=0;
+  test.error_count=0;
+  test.status=1;
+}
+
+///////////////////////////////////
+/*  Test until time budget is    */
+/*  used                         */
+///////////////////////////////////
+void ramtest_step(ramtest_state& test, int budget_us)
+{
+  if(test.status!=1)
+    return;
+
+  unsigned long long start=time_us();
+  unsigned long long now=start;
+  do
+  {
+    const ramtest_phase& phase=ramtest_phases[test.phase];
+    unsigned int count=test.words-test.offset;
+    if(count>RAMTEST_CHUNK)
+      count=RAMTEST_CHUNK;
+    unsigned int first=phase.down?test.words-test.offset-count:test.offset;
+    ramtest_chunk(test,phase,first,count);
+    test.bytes+=(double)count*sizeof(unsigned int)*(phase.op==OP_CHECK_INV?2:1);
+
+    test.offset+=count;
+    if(test.offset>=test.words)
+    {
+      test.offset=0;
+      test.phase++;
+      if(test.phase>=RAMTEST_PHASES)
+      {
+        test.phase=0;
+        test.passes++;
+      }
+    }
+    now=time_us();
+  }
+  while(now-start<(unsigned long long)budget_us);
+  test.time+=now-start;
+}
+
+///////////////////////////////////
+/*  Stop test, free memory       */
+///////////////////////////////////
+void ramtest_stop(ramtest_state& test)
+{
+  free(test.buffer);
+  test.buffer=NULL;
+  test.status=0;
+}
+
+///////////////////////////////////
+/*  Name of the running pattern  */
+///////////////////////////////////
+const char* ramtest_phasename(ramtest_state& test)
+{
+  return ramtest_phases[test.phase].name;
+}
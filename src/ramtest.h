@@ -0,0 +1,49 @@
+/*
+  RG350 Test
+  RAM test with memtest patterns. The test runs in small steps from the
+  main loop, so the screen and the buttons keep working.
+*/
+
+#ifndef RAMTEST_H
+#define RAMTEST_H
+
+#define RAMTEST_MAXERRORS  8   // failing addresses kept for the screen
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct ramtest_error
+{
+  unsigned long address;
+  unsigned int expected;
+  unsigned int bits;      // bits that failed
+};
+
+struct ramtest_state
+{
+  int status;             // 0=stopped, 1=running, 2=no memory
+  unsigned int* buffer;
+  unsigned int words;     // size of buffer in 32 bit words
+  int phase;              // current pattern phase
+  unsigned int offset;    // next word to test in this phase
+  int passes;             // complete passes of all the patterns
+  double bytes;           // bytes read or written
+  unsigned long long time; // us spent testing
+  unsigned int error_count;
+  ramtest_error errors[RAMTEST_MAXERRORS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern ramtest_state ram_test;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void ramtest_start(ramtest_state& test);
+void ramtest_step(ramtest_state& test, int budget_us);
+void ramtest_stop(ramtest_state& test);
+const char* ramtest_phasename(ramtest_state& test);
+
+#endif
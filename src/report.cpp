@@ -0,0 +1,389 @@
+/*
+  RG350 Test
+  Session report: one JSON line with the inputs seen, sticks, battery,
+  CPU, SD cards and test results, appended to a file on the SD card by
+  writing a temporary file and renaming it, so a record is never half
+  written.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include "timing.h"
+#include "factory.h"
+#include "audiotest.h"
+#include "audiodrift.h"
+#include "rumble.h"
+#include "report.h"
+
+#define REPORT_SIZE      4096        // bytes of a record
+#define REPORT_REST      3000        // axis values of a stick at rest
+#define REPORT_STILL     30          // frames of a noise window
+#define REPORT_STILLP2P  1500        // more in a window is the stick moving
+#define REPORT_SPEEDFILE (4*1024*1024)
+#define REPORT_CHUNK     (64*1024)
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct report_text
+{
+  char data[REPORT_SIZE];
+  int len;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+report_session report;
+char report_path[128]="";
+
+const char* report_cards[2]={"/usr/local/home","/media/sdcard"};
+
+///////////////////////////////////
+/*  Add text to the record       */
+///////////////////////////////////
+static void report_add(report_text& text, const char* format, ...)
+{
+  va_list args;
+  if(text.len>=REPORT_SIZE-1)
+    return;
+  va_start(args,format);
+  int len=vsnprintf(text.data+text.len,REPORT_SIZE-text.len,format,args);
+  va_end(args);
+  if(len>0)
+    text.len+=len;
+  if(text.len>REPORT_SIZE-1)
+    text.len=REPORT_SIZE-1;
+}
+
+///////////////////////////////////
+/*  Card mounted, not the empty  */
+/*  mount point                  */
+///////////////////////////////////
+int report_mounted(const char* path)
+{
+  struct stat info,parent;
+  if(stat(path,&info)<0 || !S_ISDIR(info.st_mode))
+    return 0;
+  if(strcmp(path,"/media/sdcard")==0 && stat("/media",&parent)==0 && parent.st_dev==info.st_dev)
+    return 0;
+  return 1;
+}
+
+///////////////////////////////////
+/*  Write and read speed of a    */
+/*  card, MB/s                   */
+///////////////////////////////////
+static int report_sdspeed(const char* dir, double& write_mbs, double& read_mbs)
+{
+  char path[128];
+  char* buffer=(char*)malloc(REPORT_CHUNK);
+  write_mbs=read_mbs=0;
+  if(!buffer)
+    return 0;
+  memset(buffer,0x5A,REPORT_CHUNK);
+  snprintf(path,sizeof(path),"%s/.rg350test_speed.tmp",dir);
+
+  int ok=0;
+  int fd=open(path,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  if(fd>=0)
+  {
+    unsigned long long start=time_us();
+    int written=0;
+    while(written<REPORT_SPEEDFILE && write(fd,buffer,REPORT_CHUNK)==REPORT_CHUNK)
+      written+=REPORT_CHUNK;
+    // the time of the card, not of the page cache
+    ok=(written==REPORT_SPEEDFILE && fsync(fd)==0);
+    unsigned long long elapsed=time_us()-start;
+    if(ok && elapsed)
+      write_mbs=REPORT_SPEEDFILE/(double)elapsed;
+    posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+  if(ok)
+  {
+    fd=open(path,O_RDONLY);
+    if(fd>=0)
+    {
+      unsigned long long start=time_us();
+      int bytes=0;
+      int len;
+      while((len=read(fd,buffer,REPORT_CHUNK))>0)
+        bytes+=len;
+      unsigned long long elapsed=time_us()-start;
+      if(bytes==REPORT_SPEEDFILE && elapsed)
+        read_mbs=bytes/(double)elapsed;
+      close(fd);
+    }
+  }
+  unlink(path);
+  free(buffer);
+  return ok;
+}
+
+///////////////////////////////////
+/*  Copy the file and the new    */
+/*  record to a temporary file,  */
+/*  then rename it. The line of  */
+/*  this session is replaced, so */
+/*  a session is one line        */
+///////////////////////////////////
+static int report_append(const char* dir, const report_text& text)
+{
+  struct stat info;
+  char path[128];
+  char temp[136];
+  char buffer[4096];
+  snprintf(path,sizeof(path),"%s/%s",dir,REPORT_FILE);
+  snprintf(temp,sizeof(temp),"%s.tmp",path);
+
+  // old lines to keep: all, or the ones before this session if the
+  // file is still the one written
+  long keep=0;
+  if(stat(path,&info)==0)
+    keep=(long)info.st_size;
+  if(strcmp(report.saved_path,path)==0 && keep==report.saved_size)
+    keep=report.saved_offset;
+
+  int out=open(temp,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  if(out<0)
+    return 0;
+  int ok=1;
+  int in=open(path,O_RDONLY);
+  if(in>=0)
+  {
+    long copied=0;
+    while(ok && copied<keep)
+    {
+      int len=read(in,buffer,keep-copied<(long)sizeof(buffer)?keep-copied:sizeof(buffer));
+      if(len<=0)
+      {
+        ok=0;
+        break;
+      }
+      ok=write(out,buffer,len)==len;
+      copied+=len;
+    }
+    close(in);
+  }
+  else
+    keep=0;
+  if(ok)
+    ok=write(out,text.data,text.len)==text.len;
+  // data in the card before the name points to it
+  if(fsync(out)<0)
+    ok=0;
+  if(close(out)<0)
+    ok=0;
+  if(!ok || rename(temp,path)<0)
+  {
+    unlink(temp);
+    return 0;
+  }
+  // and the new name too
+  int folder=open(dir,O_RDONLY);
+  if(folder>=0)
+  {
+    fsync(folder);
+    close(folder);
+  }
+  snprintf(report_path,sizeof(report_path),"%s",path);
+  snprintf(report.saved_path,sizeof(report.saved_path),"%s",path);
+  report.saved_offset=keep;
+  report.saved_size=keep+text.len;
+  return 1;
+}
+
+///////////////////////////////////
+/*  Start a session              */
+///////////////////////////////////
+void report_start()
+{
+  memset(&report,0,sizeof(report));
+  report.start=time_us();
+}
+
+///////////////////////////////////
+/*  Called every frame with the  */
+/*  buttons held and the axes    */
+///////////////////////////////////
+void report_track(Uint32 inputs, const int* axes)
+{
+  report.inputs|=inputs;
+  for(int f=0;f<4;f++)
+  {
+    if(axes[f]<report.axis_min[f])
+      report.axis_min[f]=axes[f];
+    if(axes[f]>report.axis_max[f])
+      report.axis_max[f]=axes[f];
+  }
+
+  // noise only from windows of frames with the stick released
+  for(int s=0;s<2;s++)
+  {
+    int x=s*2;
+    int y=x+1;
+    if(axes[x]<=-REPORT_REST || axes[x]>=REPORT_REST || axes[y]<=-REPORT_REST || axes[y]>=REPORT_REST)
+    {
+      report.still_frames[s]=0;
+      continue;
+    }
+    if(report.still_frames[s]==0)
+    {
+      report.still_min[x]=report.still_max[x]=axes[x];
+      report.still_min[y]=report.still_max[y]=axes[y];
+    }
+    for(int f=x;f<=y;f++)
+    {
+      if(axes[f]<report.still_min[f])
+        report.still_min[f]=axes[f];
+      if(axes[f]>report.still_max[f])
+        report.still_max[f]=axes[f];
+    }
+    if(++report.still_frames[s]<REPORT_STILL)
+      continue;
+    report.still_frames[s]=0;
+    // a slow move inside the dead zone isn't noise
+    if(report.still_max[x]-report.still_min[x]>REPORT_STILLP2P || report.still_max[y]-report.still_min[y]>REPORT_STILLP2P)
+      continue;
+    report.still_windows[s]++;
+    report.noise_sum[x]+=report.still_max[x]-report.still_min[x];
+    report.noise_sum[y]+=report.still_max[y]-report.still_min[y];
+  }
+}
+
+///////////////////////////////////
+/*  Mean peak to peak of an axis */
+/*  at rest, -1 if never still   */
+///////////////////////////////////
+int report_noise(int axis)
+{
+  int windows=report.still_windows[axis/2];
+  if(windows==0)
+    return -1;
+  return report.noise_sum[axis]/windows;
+}
+
+///////////////////////////////////
+/*  Write the record of the      */
+/*  session, 1 if ok             */
+///////////////////////////////////
+int report_write(const report_info& info)
+{
+  static report_text text;
+  char date[32];
+  int f;
+
+  time_t now=time(NULL);
+  strftime(date,sizeof(date),"%Y-%m-%dT%H:%M:%S",localtime(&now));
+  text.len=0;
+  report_add(text,"{\"time\":\"%s\",\"version\":\"%s\",\"session_s\":%u",date,info.version,(unsigned int)((time_us()-report.start)/1000000));
+
+  // buttons
+  report_add(text,",\"buttons_missing\":[");
+  int missing=0;
+  for(f=0;f<FACTORY_BUTTONS;f++)
+    if(!(report.inputs & (1<<f)))
+      report_add(text,"%s\"%s\"",missing++?",":"",factory_names[f]);
+  report_add(text,"],\"buttons_seen\":%i",FACTORY_BUTTONS-missing);
+
+  // sticks: range and mean peak to peak at rest
+  report_add(text,",\"sticks\":[");
+  for(f=0;f<2;f++)
+  {
+    int x=f*2;
+    int y=x+1;
+    report_add(text,"%s{\"x\":[%i,%i],\"y\":[%i,%i],\"noise\":",f?",":"",
+      report.axis_min[x],report.axis_max[x],report.axis_min[y],report.axis_max[y]);
+    if(report.still_windows[f])
+      report_add(text,"[%i,%i]}",report_noise(x),report_noise(y));
+    else
+      report_add(text,"null}");
+  }
+  report_add(text,"]");
+
+  // battery and cpu
+  int microvolts=0;
+  FILE* fd=fopen("/sys/class/power_supply/battery/voltage_now","r");
+  if(fd)
+  {
+    if(fscanf(fd,"%d",&microvolts)!=1)
+      microvolts=0;
+    fclose(fd);
+  }
+  report.microvolts=microvolts;
+  report_add(text,",\"battery\":{\"uv\":%i,\"level\":%i,\"charging\":%i},\"cpu_mhz\":%i",microvolts,info.battery_level,info.charging,info.cpu_mhz);
+
+  // cards: size and speed
+  report_add(text,",\"sd\":[");
+  int cards=0;
+  for(f=0;f<2;f++)
+  {
+    struct statvfs size;
+    double& write_mbs=report.write_mbs[f];
+    double& read_mbs=report.read_mbs[f];
+    report.card_ok[f]=0;
+    if(!report_mounted(report_cards[f]) || statvfs(report_cards[f],&size)<0)
+      continue;
+    report.card_ok[f]=1;
+    // 4 MiB written and read, only once every session
+    if(!(report.speed_done & (1<<f)))
+    {
+      report_sdspeed(report_cards[f],write_mbs,read_mbs);
+      report.speed_done|=1<<f;
+    }
+    report_add(text,"%s{\"path\":\"%s\",\"total_mib\":%llu,\"free_mib\":%llu,\"write_mbs\":%.2f,\"read_mbs\":%.2f}",cards++?",":"",
+      report_cards[f],(unsigned long long)size.f_blocks*size.f_frsize/(1024*1024),(unsigned long long)size.f_bavail*size.f_frsize/(1024*1024),write_mbs,read_mbs);
+  }
+  report_add(text,"]");
+
+  // tests run in this session
+  if(factory.status==2)
+  {
+    report_add(text,",\"factory\":{\"result\":\"%s\",\"passed\":%i,\"total_ms\":%u,\"wrong\":%u,\"steps_ms\":{",
+      factory.passed==FACTORY_STEPS?"pass":"fail",factory.passed,factory.total_ms,factory.wrong);
+    // failed steps are negative
+    for(f=0;f<FACTORY_STEPS;f++)
+      report_add(text,"%s\"%s\":%i",f?",":"",factory_names[f],factory.steps[f].result==FACTORY_PASS?(int)factory.steps[f].time_ms:-1);
+    report_add(text,"}}");
+  }
+  if(drift_results.status==2)
+    report_add(text,",\"audio_drift_ppm\":%.1f",drift_results.ppm);
+  if(audio_results.status==2)
+  {
+    int best_r=-1,best_b=-1;
+    for(int r=0;r<AUDIOTEST_RATES;r++)
+      for(int b=0;b<AUDIOTEST_BUFFERS;b++)
+        if(audio_results.results[r][b].safe && (best_r<0 || audio_results.results[r][b].latency_ms<audio_results.results[best_r][best_b].latency_ms))
+        {
+          best_r=r;
+          best_b=b;
+        }
+    if(best_r>=0)
+      report_add(text,",\"audio_latency\":{\"rate\":%i,\"samples\":%i,\"ms\":%.1f}",
+        audiotest_rates[best_r],audiotest_buffers[best_b],audio_results.results[best_r][best_b].latency_ms);
+  }
+  if(rumble_results.plays)
+    report_add(text,",\"rumble_us\":{\"avg\":%u,\"max\":%u}",(unsigned int)(rumble_results.total_us/rumble_results.plays),rumble_results.max_us);
+  report_add(text,"}\n");
+  // a cut record would break the file
+  if(text.len>=REPORT_SIZE-1)
+    return 0;
+
+  // external card first, lines of many units are collected from one card
+  report_path[0]=0;
+  for(f=1;f>=0;f--)
+    if(report_mounted(report_cards[f]) && report_append(report_cards[f],text))
+      return 1;
+  return 0;
+}
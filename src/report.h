@@ -0,0 +1,70 @@
+/*
+  RG350 Test
+  Session report: one JSON line with the inputs seen, sticks, battery,
+  CPU, SD cards and test results, appended to a file on the SD card by
+  writing a temporary file and renaming it, so a record is never half
+  written.
+*/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define REPORT_FILE  "rg350test_report.jsonl"
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct report_info
+{
+  const char* version;
+  int battery_level;      // %
+  int charging;
+  int cpu_mhz;
+};
+
+struct report_session
+{
+  unsigned long long start;
+  Uint32 inputs;          // every button pressed in the session
+  int axis_min[4];
+  int axis_max[4];
+  // noise: peak to peak of the axes in windows where the stick is still
+  int still_min[4];
+  int still_max[4];
+  int still_frames[2];    // frames of the window of every stick
+  int still_windows[2];   // windows with the stick at rest
+  int noise_sum[4];
+  // measured by the last report
+  int microvolts;
+  int card_ok[2];         // internal and external card mounted
+  double write_mbs[2];    // measured once every session
+  double read_mbs[2];
+  int speed_done;         // bit of every card measured
+  // line of the session, replaced when the report is written again
+  char saved_path[128];
+  long saved_offset;      // where the line starts
+  long saved_size;        // size of the file after writing it
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern report_session report;
+extern char report_path[128];   // last file written, empty if it failed
+extern const char* report_cards[2];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void report_start();
+void report_track(Uint32 inputs, const int* axes);
+int report_mounted(const char* path);
+int report_noise(int axis);
+int report_write(const report_info& info);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+  RG350 Test
+  Rumble patterns: every effect is uploaded once at init, patterns play
+  them by id in a timed sequence, and every Shake_Play is timed.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <string.h>
+#include <shake.h>  // rumble lib
+#include "timing.h"
+#include "rumble.h"
+
+#define EFFECT_CLICK      0
+#define EFFECT_RAMPUP     1
+#define EFFECT_RAMPDOWN   2
+#define EFFECT_LEVEL25    3
+#define EFFECT_LEVEL50    4
+#define EFFECT_LEVEL75    5
+#define EFFECT_LEVEL100   6
+#define EFFECT_BUZZ       7
+#define EFFECT_COUNT      8
+
+#define RUMBLE_STEPS      10
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct rumble_step
+{
+  int effect;
+  int at_ms;              // from the start of the pattern
+};
+
+struct rumble_pattern
+{
+  int count;
+  rumble_step steps[RUMBLE_STEPS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+rumble_stats rumble_results;
+const char* rumble_names[RUMBLE_PATTERNS]={"click","double click","ramp up","ramp down","magnitude sweep","pulse train","buzz"};
+
+static const rumble_pattern rumble_patterns[RUMBLE_PATTERNS]={
+  {1,{{EFFECT_CLICK,0}}},
+  {2,{{EFFECT_CLICK,0},{EFFECT_CLICK,150}}},
+  {1,{{EFFECT_RAMPUP,0}}},
+  {1,{{EFFECT_RAMPDOWN,0}}},
+  {4,{{EFFECT_LEVEL25,0},{EFFECT_LEVEL50,300},{EFFECT_LEVEL75,600},{EFFECT_LEVEL100,900}}},
+  {10,{{EFFECT_CLICK,0},{EFFECT_CLICK,100},{EFFECT_CLICK,200},{EFFECT_CLICK,300},{EFFECT_CLICK,400},
+       {EFFECT_CLICK,500},{EFFECT_CLICK,600},{EFFECT_CLICK,700},{EFFECT_CLICK,800},{EFFECT_CLICK,900}}},
+  {1,{{EFFECT_BUZZ,0}}}
+};
+
+static Shake_Device* rumble_device=NULL;
+static int rumble_ids[EFFECT_COUNT];     // -1=not uploaded
+static int rumble_step_next=0;
+static int rumble_last=-1;               // effect of the last step
+static unsigned long long rumble_start=0;
+
+///////////////////////////////////
+/*  Periodic effect, the driver  */
+/*  turns it into a magnitude    */
+/*  with an envelope             */
+///////////////////////////////////
+static int rumble_upload(int magnitude, int length, int attack, int fade)
+{
+  Shake_Effect effect;
+  Shake_InitEffect(&effect,SHAKE_EFFECT_PERIODIC);
+  effect.u.periodic.waveform=SHAKE_PERIODIC_SINE;
+  effect.u.periodic.period=0.1*0x100;
+  effect.u.periodic.magnitude=magnitude;
+  effect.u.periodic.envelope.attackLength=attack;
+  effect.u.periodic.envelope.attackLevel=0;
+  effect.u.periodic.envelope.fadeLength=fade;
+  effect.u.periodic.envelope.fadeLevel=0;
+  effect.direction=0x4000;
+  effect.length=length;
+  effect.delay=0;
+  return Shake_UploadEffect(rumble_device,&effect);
+}
+
+///////////////////////////////////
+/*  Play an effect and time the  */
+/*  call                         */
+///////////////////////////////////
+static void rumble_effect(int pattern, int effect, unsigned long long command)
+{
+  if(rumble_ids[effect]<0)
+    return;
+  // a new effect replaces the one still playing
+  if(rumble_last>=0 && rumble_last!=effect && rumble_ids[rumble_last]>=0)
+    Shake_Stop(rumble_device,rumble_ids[rumble_last]);
+  Shake_Play(rumble_device,rumble_ids[effect]);
+  rumble_last=effect;
+
+  unsigned int elapsed=(unsigned int)(time_us()-command);
+  rumble_results.plays++;
+  rumble_results.last_us=elapsed;
+  rumble_results.total_us+=elapsed;
+  if(elapsed>rumble_results.max_us)
+    rumble_results.max_us=elapsed;
+  rumble_results.pattern_us[pattern]=elapsed;
+}
+
+///////////////////////////////////
+/*  Open the device and upload   */
+/*  all the effects              */
+///////////////////////////////////
+void rumble_init()
+{
+  int f;
+  memset(&rumble_results,0,sizeof(rumble_results));
+  rumble_results.playing=-1;
+  for(f=0;f<EFFECT_COUNT;f++)
+    rumble_ids[f]=-1;
+
+  Shake_Init();
+  if(Shake_NumOfDevices()<=0)
+    return;
+  rumble_device=Shake_Open(0);
+  if(!rumble_device)
+    return;
+  rumble_results.available=1;
+
+  rumble_ids[EFFECT_CLICK]=rumble_upload(0x7FFF,40,0,0);
+  rumble_ids[EFFECT_RAMPUP]=rumble_upload(0x7FFF,1000,1000,0);
+  rumble_ids[EFFECT_RAMPDOWN]=rumble_upload(0x7FFF,1000,0,1000);
+  rumble_ids[EFFECT_LEVEL25]=rumble_upload(0x2000,250,0,0);
+  rumble_ids[EFFECT_LEVEL50]=rumble_upload(0x4000,250,0,0);
+  rumble_ids[EFFECT_LEVEL75]=rumble_upload(0x6000,250,0,0);
+  rumble_ids[EFFECT_LEVEL100]=rumble_upload(0x7FFF,250,0,0);
+  rumble_ids[EFFECT_BUZZ]=rumble_upload(0x6000,2000,0x100,0x100);
+  for(f=0;f<EFFECT_COUNT;f++)
+    if(rumble_ids[f]>=0)
+      rumble_results.uploaded++;
+}
+
+///////////////////////////////////
+/*  Start a pattern, it replaces */
+/*  the one playing              */
+///////////////////////////////////
+void rumble_play(int pattern)
+{
+  if(!rumble_results.available || pattern<0 || pattern>=RUMBLE_PATTERNS)
+    return;
+  rumble_start=time_us();
+  rumble_results.playing=pattern;
+  rumble_step_next=0;
+  rumble_update();
+}
+
+///////////////////////////////////
+/*  Called every frame, play the */
+/*  steps of the pattern on time */
+///////////////////////////////////
+void rumble_update()
+{
+  if(rumble_results.playing<0)
+    return;
+  const rumble_pattern& pattern=rumble_patterns[rumble_results.playing];
+  unsigned long long now=time_us();
+  while(rumble_step_next<pattern.count)
+  {
+    const rumble_step& step=pattern.steps[rumble_step_next];
+    unsigned long long at=rumble_start+step.at_ms*1000ULL;
+    if(now<at)
+      return;
+    rumble_step_next++;
+    // steps are commanded by the frame, the first one by the button
+    rumble_effect(rumble_results.playing,step.effect,rumble_step_next==1?rumble_start:now);
+  }
+  rumble_results.playing=-1;
+}
+
+///////////////////////////////////
+/*  Erase the effects and close  */
+///////////////////////////////////
+void rumble_end()
+{
+  if(rumble_device)
+  {
+    for(int f=0;f<EFFECT_COUNT;f++)
+      if(rumble_ids[f]>=0)
+        Shake_EraseEffect(rumble_device,rumble_ids[f]);
+    Shake_Close(rumble_device);
+    rumble_device=NULL;
+  }
+  Shake_Quit();
+}
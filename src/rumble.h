@@ -0,0 +1,48 @@
+/*
+  RG350 Test
+  Rumble patterns: every effect is uploaded once at init, patterns play
+  them by id in a timed sequence, and every Shake_Play is timed.
+*/
+
+#ifndef RUMBLE_H
+#define RUMBLE_H
+
+#define RUMBLE_CLICK        0
+#define RUMBLE_DOUBLECLICK  1
+#define RUMBLE_RAMPUP       2
+#define RUMBLE_RAMPDOWN     3
+#define RUMBLE_SWEEP        4   // magnitude in 4 steps
+#define RUMBLE_PULSES       5   // train of 10 clicks
+#define RUMBLE_BUZZ         6   // 2 s sine, the old rumble test
+#define RUMBLE_PATTERNS     7
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct rumble_stats
+{
+  int available;          // 0=no rumble device
+  int uploaded;           // effects in the device
+  int playing;            // pattern, -1=none
+  unsigned int plays;     // Shake_Play calls
+  unsigned int last_us;   // command to Shake_Play return
+  unsigned int max_us;
+  unsigned long long total_us;
+  unsigned int pattern_us[RUMBLE_PATTERNS];   // last latency of every pattern
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern rumble_stats rumble_results;
+extern const char* rumble_names[RUMBLE_PATTERNS];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void rumble_init();
+void rumble_play(int pattern);
+void rumble_update();
+void rumble_end();
+
+#endif
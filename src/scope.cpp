@@ -0,0 +1,107 @@
+/*
+  RG350 Test
+  Capture of the output mix: the postmix hook writes the last samples
+  into a lock-free ring, the main thread copies a window of them to
+  draw the oscilloscope and the spectrum.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include "audio.h"
+#include "scope.h"
+
+#define SCOPE_TRIES  4   // copies before giving up, the writer was faster
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+// only the audio thread writes, only the main thread reads
+static Sint16 scope_left[SCOPE_RING];
+static Sint16 scope_right[SCOPE_RING];
+static volatile unsigned int scope_written=0;   // frames written since the start
+static volatile unsigned int scope_clipped=0;   // samples at full scale
+
+///////////////////////////////////
+/*  Postmix hook, copy the mix   */
+///////////////////////////////////
+static void scope_hook(void* udata, Uint8* stream, int len)
+{
+  Sint16* in=(Sint16*)stream;
+  int channels=audio.channels;
+  int frames=len/(2*channels);
+  unsigned int written=scope_written;
+  unsigned int clipped=scope_clipped;
+  // half the ring at most, so the window being read isn't overwritten
+  int skip=frames>SCOPE_RING/2?frames-SCOPE_RING/2:0;
+
+  for(int f=0;f<frames;f++)
+  {
+    Sint16 left=in[0];
+    Sint16 right=channels>1?in[1]:left;
+    in+=channels;
+    if(left==32767 || left==-32768)
+      clipped++;
+    if(right==32767 || right==-32768)
+      clipped++;
+    if(f<skip)
+      continue;
+    scope_left[(written+f-skip)&(SCOPE_RING-1)]=left;
+    scope_right[(written+f-skip)&(SCOPE_RING-1)]=right;
+  }
+  // samples are in memory before the reader can see them
+  __sync_synchronize();
+  scope_written=written+frames-skip;
+  scope_clipped=clipped;
+}
+
+///////////////////////////////////
+/*  Capture every mix            */
+///////////////////////////////////
+void scope_init()
+{
+  audio_addhook(scope_hook,NULL);
+}
+
+///////////////////////////////////
+/*  Copy the last samples, 0 if  */
+/*  the writer overwrote them    */
+/*  while copying                */
+///////////////////////////////////
+int scope_read(Sint16* left, Sint16* right, int count)
+{
+  if(count>SCOPE_RING/2)
+    return 0;
+  for(int t=0;t<SCOPE_TRIES;t++)
+  {
+    unsigned int end=scope_written;
+    __sync_synchronize();
+    for(int f=0;f<count;f++)
+    {
+      unsigned int index=end-count+f;
+      // before the first mix there is silence
+      if(end<(unsigned int)count && f<count-(int)end)
+      {
+        left[f]=right[f]=0;
+        continue;
+      }
+      left[f]=scope_left[index&(SCOPE_RING-1)];
+      right[f]=scope_right[index&(SCOPE_RING-1)];
+    }
+    __sync_synchronize();
+    // the writer didn't reach the copied samples, counting the up to
+    // SCOPE_RING/2 frames it may be storing after scope_written
+    if(scope_written-end<=(unsigned int)(SCOPE_RING/2-count))
+      return 1;
+  }
+  return 0;
+}
+
+///////////////////////////////////
+/*  Samples at full scale since  */
+/*  the start                    */
+///////////////////////////////////
+unsigned int scope_clips()
+{
+  return scope_clipped;
+}
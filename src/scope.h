@@ -0,0 +1,25 @@
+/*
+  RG350 Test
+  Capture of the output mix: the postmix hook writes the last samples
+  into a lock-free ring, the main thread copies a window of them to
+  draw the oscilloscope and the spectrum.
+*/
+
+#ifndef SCOPE_H
+#define SCOPE_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define SCOPE_RING   4096   // sample frames, power of 2
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void scope_init();
+int scope_read(Sint16* left, Sint16* right, int count);
+unsigned int scope_clips();
+
+#endif
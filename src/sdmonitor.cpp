@@ -0,0 +1,160 @@
+/*
+  RG350 Test
+  Mount table watcher, detects when a sdcard is inserted or removed.
+
+  /proc/self/mounts raises POLLPRI when the mount table changes, so the
+  thread sleeps in poll() and only reads the table after a change.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include "sdmonitor.h"
+
+///////////////////////////////////
+/*  Search mount point in table  */
+///////////////////////////////////
+static void sdmon_scan(sd_monitor& mon, int& mounted, char* line)
+{
+  char buffer[4096];
+  int len=0;
+  int ret;
+
+  mounted=0;
+  line[0]=0;
+  if(mon.is_proc)
+  {
+    lseek(mon.fd,0,SEEK_SET);
+    while(len<(int)sizeof(buffer)-1 && (ret=read(mon.fd,buffer+len,sizeof(buffer)-1-len))>0)
+      len+=ret;
+  }
+  else
+  {
+    int fd=open(mon.mounts_path,O_RDONLY);
+    if(fd<0)
+      return;
+    while(len<(int)sizeof(buffer)-1 && (ret=read(fd,buffer+len,sizeof(buffer)-1-len))>0)
+      len+=ret;
+    close(fd);
+  }
+  buffer[len]=0;
+
+  // each line is "device mountpoint fstype options 0 0"
+  char* start=buffer;
+  while(*start)
+  {
+    char* end=strchr(start,'\n');
+    if(end)
+      *end=0;
+    char dev[64];
+    char point[64];
+    if(sscanf(start,"%63s %63s",dev,point)==2 && strcmp(point,mon.mountpoint)==0)
+    {
+      mounted=1;
+      strncpy(line,start,sizeof(mon.line)-1);
+      line[sizeof(mon.line)-1]=0;
+    }
+    if(!end)
+      break;
+    start=end+1;
+  }
+}
+
+///////////////////////////////////
+/*  Open the mount table         */
+///////////////////////////////////
+int sdmon_open(sd_monitor& mon, const char* mounts_path, const char* mountpoint)
+{
+  struct stat buffer;
+
+  strncpy(mon.mounts_path,mounts_path,sizeof(mon.mounts_path)-1);
+  mon.mounts_path[sizeof(mon.mounts_path)-1]=0;
+  strncpy(mon.mountpoint,mountpoint,sizeof(mon.mountpoint)-1);
+  mon.mountpoint[sizeof(mon.mountpoint)-1]=0;
+  // mount table never has a trailing slash
+  int len=strlen(mon.mountpoint);
+  if(len>1 && mon.mountpoint[len-1]=='/')
+    mon.mountpoint[len-1]=0;
+
+  mon.mounted=0;
+  mon.line[0]=0;
+  mon.mtime=0;
+  mon.size=0;
+  mon.fd=open(mon.mounts_path,O_RDONLY);
+  if(mon.fd<0)
+    return 0;
+
+  // procfs files report size 0, a fake table is a regular file with data
+  mon.is_proc=1;
+  if(fstat(mon.fd,&buffer)==0 && S_ISREG(buffer.st_mode) && buffer.st_size>0)
+  {
+    mon.is_proc=0;
+    mon.mtime=buffer.st_mtime;
+    mon.size=buffer.st_size;
+  }
+
+  sdmon_scan(mon,mon.mounted,mon.line);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Wait for a change in the     */
+/*  mount table. Return 1 if the */
+/*  mount point changed          */
+///////////////////////////////////
+int sdmon_wait(sd_monitor& mon, int timeout_ms)
+{
+  struct stat buffer;
+
+  if(mon.fd<0)
+  {
+    poll(NULL,0,timeout_ms);
+    return 0;
+  }
+
+  if(mon.is_proc)
+  {
+    struct pollfd pfd;
+    pfd.fd=mon.fd;
+    pfd.events=POLLPRI;
+    pfd.revents=0;
+    if(poll(&pfd,1,timeout_ms)<=0 || !(pfd.revents & (POLLPRI | POLLERR)))
+      return 0;
+  }
+  else
+  {
+    // plain files are always readable, compare modification time instead.
+    // It has 1 s resolution, the size catches a mount and unmount in that second
+    poll(NULL,0,timeout_ms);
+    if(stat(mon.mounts_path,&buffer)!=0 || (buffer.st_mtime==mon.mtime && buffer.st_size==mon.size))
+      return 0;
+    mon.mtime=buffer.st_mtime;
+    mon.size=buffer.st_size;
+  }
+
+  int mounted;
+  char line[sizeof(mon.line)];
+  sdmon_scan(mon,mounted,line);
+  if(mounted==mon.mounted && strcmp(line,mon.line)==0)
+    return 0;
+
+  mon.mounted=mounted;
+  strcpy(mon.line,line);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Close the mount table        */
+///////////////////////////////////
+void sdmon_close(sd_monitor& mon)
+{
+  if(mon.fd>=0)
+    close(mon.fd);
+  mon.fd=-1;
+}
@@ -0,0 +1,35 @@
+/*
+  RG350 Test
+  Mount table watcher, detects when a sdcard is inserted or removed.
+
+  The mounts file and the mount point are parameters, so a plain text
+  file can be used as a fake mount table when testing on a PC, set with
+  RG350TEST_MOUNTS.
+*/
+
+#ifndef SDMONITOR_H
+#define SDMONITOR_H
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct sd_monitor
+{
+  int fd;                 // mounts file, -1 if not opened
+  int is_proc;            // 1=procfs file (poll POLLPRI), 0=plain file (check mtime and size)
+  long mtime;             // last modification time of a plain file
+  long size;              // and its size
+  int mounted;            // mount point found in last read of the table
+  char line[128];         // mount table line of the mount point, to detect a card swap
+  char mounts_path[64];
+  char mountpoint[64];
+};
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+int sdmon_open(sd_monitor& mon, const char* mounts_path, const char* mountpoint);
+int sdmon_wait(sd_monitor& mon, int timeout_ms);
+void sdmon_close(sd_monitor& mon);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+  RG350 Test
+  Sleep accuracy test: requested against real sleep time of SDL_Delay,
+  nanosleep and clock_nanosleep with absolute time, from 1 to 20 ms.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <time.h>
+#include <pthread.h>
+#include <SDL/SDL.h>
+#include "timing.h"
+#include "sleeptest.h"
+
+#define SLEEP_SAMPLES  20   // sleeps of every time and method
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+sleep_test sleep_results;
+const char* sleep_names[SLEEP_METHODS]={"SDL_Delay","nanosleep","abstime"};
+const int sleep_requests_ms[SLEEP_REQUESTS]={1,2,5,10,16,20};
+const char* sleep_binnames[SLEEP_BINS]={"<50us","<100us","<250us","<500us","<1ms","<2ms","<5ms",">5ms"};
+static const unsigned int sleep_bins_us[SLEEP_BINS-1]={50,100,250,500,1000,2000,5000};
+static pthread_t sleep_th;
+static int sleep_running=0;
+static volatile int sleep_stop=0;
+
+///////////////////////////////////
+/*  Sleep with a method, return  */
+/*  the real time in us          */
+///////////////////////////////////
+static unsigned long long sleep_once(int method, int ms)
+{
+  unsigned long long start=time_us();
+  struct timespec ts;
+
+  switch(method)
+  {
+    case SLEEP_SDLDELAY:
+      SDL_Delay(ms);
+      break;
+    case SLEEP_NANOSLEEP:
+      ts.tv_sec=0;
+      ts.tv_nsec=ms*1000000L;
+      nanosleep(&ts,NULL);
+      break;
+    case SLEEP_ABSTIME:
+      clock_gettime(CLOCK_MONOTONIC,&ts);
+      start=(unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+      ts.tv_nsec+=ms*1000000L;
+      if(ts.tv_nsec>=1000000000L)
+      {
+        ts.tv_sec++;
+        ts.tv_nsec-=1000000000L;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL);
+      break;
+  }
+  return time_us()-start;
+}
+
+///////////////////////////////////
+/*  Thread that run the test     */
+///////////////////////////////////
+static void* sleeptest_thd(void* p)
+{
+  for(int m=0;m<SLEEP_METHODS && !sleep_stop;m++)
+  {
+    sleep_method& method=sleep_results.methods[m];
+    int f;
+    for(f=0;f<SLEEP_BINS;f++)
+      method.histogram[f]=0;
+    sleep_results.count=0;
+
+    for(int r=0;r<SLEEP_REQUESTS && !sleep_stop;r++)
+    {
+      double total=0;
+      unsigned int max=0;
+      unsigned int requested=sleep_requests_ms[r]*1000;
+      for(int s=0;s<SLEEP_SAMPLES && !sleep_stop;s++)
+      {
+        unsigned long long real=sleep_once(m,sleep_requests_ms[r]);
+        // SDL_Delay can also wake up early
+        unsigned int overshoot=real>requested?(unsigned int)(real-requested):0;
+        total+=overshoot;
+        if(overshoot>max)
+          max=overshoot;
+        for(f=0;f<SLEEP_BINS-1 && overshoot>=sleep_bins_us[f];f++)
+          ;
+        method.histogram[f]++;
+      }
+      method.mean_us[r]=total/SLEEP_SAMPLES;
+      method.max_us[r]=max;
+      sleep_results.count++;
+    }
+  }
+  sleep_results.status=2;
+  return NULL;
+}
+
+///////////////////////////////////
+/*  Start test in background     */
+///////////////////////////////////
+void sleeptest_start()
+{
+  if(sleep_running)
+    return;
+  sleep_stop=0;
+  sleep_results.status=1;
+  if(pthread_create(&sleep_th,NULL,sleeptest_thd,NULL)==0)
+    sleep_running=1;
+  else
+    sleep_results.status=0;
+}
+
+///////////////////////////////////
+/*  Wait for the test to end     */
+///////////////////////////////////
+void sleeptest_wait()
+{
+  if(!sleep_running)
+    return;
+  pthread_join(sleep_th,NULL);
+  sleep_running=0;
+}
+
+///////////////////////////////////
+/*  Stop test thread             */
+///////////////////////////////////
+void sleeptest_end()
+{
+  if(sleep_running)
+  {
+    sleep_stop=1;
+    pthread_join(sleep_th,NULL);
+    sleep_running=0;
+  }
+}
@@ -0,0 +1,50 @@
+/*
+  RG350 Test
+  Sleep accuracy test: requested against real sleep time of SDL_Delay,
+  nanosleep and clock_nanosleep with absolute time, from 1 to 20 ms.
+*/
+
+#ifndef SLEEPTEST_H
+#define SLEEPTEST_H
+
+#define SLEEP_SDLDELAY    0
+#define SLEEP_NANOSLEEP   1
+#define SLEEP_ABSTIME     2
+#define SLEEP_METHODS     3
+
+#define SLEEP_REQUESTS    6   // sleep times tested
+#define SLEEP_BINS        8   // overshoot histogram
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct sleep_method
+{
+  double mean_us[SLEEP_REQUESTS];     // overshoot of every sleep time
+  unsigned int max_us[SLEEP_REQUESTS];
+  unsigned int histogram[SLEEP_BINS]; // overshoots of all sleep times
+};
+
+struct sleep_test
+{
+  int status;             // 0=not run, 1=running, 2=done
+  int count;              // sleep times measured of the current method
+  sleep_method methods[SLEEP_METHODS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern sleep_test sleep_results;
+extern const char* sleep_names[SLEEP_METHODS];
+extern const int sleep_requests_ms[SLEEP_REQUESTS];
+extern const char* sleep_binnames[SLEEP_BINS];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void sleeptest_start();
+void sleeptest_wait();
+void sleeptest_end();
+
+#endif
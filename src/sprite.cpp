@@ -0,0 +1,307 @@
+/*
+  RG350 Test
+  Colorkey sprites compiled to lists of opaque spans. Drawing a sprite
+  copies every span with memcpy, without testing the colorkey of every
+  pixel.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include "sprite.h"
+
+#define SPRITE_SLOTS  257   // hash table of registered sprites and their scaled copies, prime
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct sprite_slot
+{
+  SDL_Surface* surface;
+  span_sprite* sprite;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+static sprite_slot sprite_slots[SPRITE_SLOTS];
+
+///////////////////////////////////
+/*  Count and fill spans of a    */
+/*  surface with pixels of T.    */
+/*  Without sprite only counts   */
+///////////////////////////////////
+template<typename T> static void sprite_spans(SDL_Surface* src, span_sprite* sprite, int& spans, int& opaque)
+{
+  T key=(T)src->format->colorkey;
+  T* pixels=sprite?(T*)sprite->pixels:NULL;
+  int x,y;
+
+  spans=0;
+  opaque=0;
+  for(y=0;y<src->h;y++)
+  {
+    T* row=(T*)((Uint8*)src->pixels+y*src->pitch);
+    if(sprite)
+      sprite->row_start[y]=spans;
+    x=0;
+    while(x<src->w)
+    {
+      if(row[x]==key)
+      {
+        x++;
+        continue;
+      }
+      int start=x;
+      while(x<src->w && row[x]!=key)
+      {
+        if(pixels)
+          pixels[opaque]=row[x];
+        opaque++;
+        x++;
+      }
+      if(sprite)
+      {
+        sprite_span& current=sprite->spans[spans];
+        current.x=start;
+        current.len=x-start;
+        current.offset=opaque-(x-start);
+      }
+      spans++;
+    }
+  }
+  if(sprite)
+    sprite->row_start[src->h]=spans;
+}
+
+///////////////////////////////////
+/*  Build span lists of a 16 or  */
+/*  32 bpp colorkey surface      */
+///////////////////////////////////
+span_sprite* sprite_compile(SDL_Surface* src)
+{
+  if(!src || (src->format->BytesPerPixel!=2 && src->format->BytesPerPixel!=4) || !(src->flags & SDL_SRCCOLORKEY))
+    return NULL;
+  if(SDL_MUSTLOCK(src) && SDL_LockSurface(src)<0)
+    return NULL;
+
+  int bpp=src->format->BytesPerPixel;
+  int spans,opaque;
+
+  // first pass counts, second pass fills
+  if(bpp==2)
+    sprite_spans<Uint16>(src,NULL,spans,opaque);
+  else
+    sprite_spans<Uint32>(src,NULL,spans,opaque);
+
+  span_sprite* sprite=(span_sprite*)malloc(sizeof(span_sprite));
+  if(sprite)
+  {
+    sprite->w=src->w;
+    sprite->h=src->h;
+    sprite->bpp=bpp;
+    sprite->Rmask=src->format->Rmask;
+    sprite->Gmask=src->format->Gmask;
+    sprite->Bmask=src->format->Bmask;
+    sprite->pixels=(Uint8*)malloc(opaque*bpp+1);
+    sprite->spans=(sprite_span*)malloc(spans*sizeof(sprite_span)+1);
+    sprite->row_start=(int*)malloc((src->h+1)*sizeof(int));
+    if(!sprite->pixels || !sprite->spans || !sprite->row_start)
+    {
+      sprite_free(sprite);
+      sprite=NULL;
+    }
+  }
+
+  if(sprite)
+  {
+    if(bpp==2)
+      sprite_spans<Uint16>(src,sprite,spans,opaque);
+    else
+      sprite_spans<Uint32>(src,sprite,spans,opaque);
+  }
+
+  if(SDL_MUSTLOCK(src))
+    SDL_UnlockSurface(src);
+  return sprite;
+}
+
+///////////////////////////////////
+/*  Free a sprite                */
+///////////////////////////////////
+void sprite_free(span_sprite* sprite)
+{
+  if(!sprite)
+    return;
+  free(sprite->pixels);
+  free(sprite->spans);
+  free(sprite->row_start);
+  free(sprite);
+}
+
+///////////////////////////////////
+/*  Draw a sprite, return 0 if   */
+/*  the surface has another      */
+/*  pixel format                 */
+///////////////////////////////////
+int sprite_draw(span_sprite* sprite, SDL_Surface* dst, int x, int y)
+{
+  SDL_PixelFormat* format=dst->format;
+  if(format->BytesPerPixel!=sprite->bpp || format->Rmask!=sprite->Rmask || format->Gmask!=sprite->Gmask || format->Bmask!=sprite->Bmask)
+    return 0;
+  const int bpp=sprite->bpp;
+
+  // visible rows and columns
+  const SDL_Rect& clip=dst->clip_rect;
+  int first_row=clip.y>y?clip.y-y:0;
+  int last_row=clip.y+clip.h-y;
+  if(last_row>sprite->h)
+    last_row=sprite->h;
+  int left=clip.x-x;
+  int right=clip.x+clip.w-x;
+  if(first_row>=last_row || left>=sprite->w || right<=0)
+    return 1;
+
+  if(SDL_MUSTLOCK(dst) && SDL_LockSurface(dst)<0)
+    return 1;
+  Uint8* dst_row=(Uint8*)dst->pixels+(y+first_row)*dst->pitch+x*bpp;
+  for(int row=first_row;row<last_row;row++,dst_row+=dst->pitch)
+  {
+    sprite_span* span=sprite->spans+sprite->row_start[row];
+    sprite_span* end=sprite->spans+sprite->row_start[row+1];
+    if(left<=0 && right>=sprite->w)
+    {
+      for(;span<end;span++)
+        memcpy(dst_row+span->x*bpp,sprite->pixels+span->offset*bpp,span->len*bpp);
+    }
+    else
+    {
+      // sprite crosses the clip rectangle, cut spans
+      for(;span<end;span++)
+      {
+        int start=span->x;
+        int stop=span->x+span->len;
+        if(start<left)
+          start=left;
+        if(stop>right)
+          stop=right;
+        if(start<stop)
+          memcpy(dst_row+start*bpp,sprite->pixels+(span->offset+start-span->x)*bpp,(stop-start)*bpp);
+      }
+    }
+  }
+  if(SDL_MUSTLOCK(dst))
+    SDL_UnlockSurface(dst);
+  return 1;
+}
+
+///////////////////////////////////
+/*  Slot of a surface in the     */
+/*  hash table                   */
+///////////////////////////////////
+static int sprite_slot_of(SDL_Surface* src)
+{
+  int slot=(int)(((unsigned long)src>>4)%SPRITE_SLOTS);
+  for(int f=0;f<SPRITE_SLOTS;f++)
+  {
+    if(sprite_slots[slot].surface==src || sprite_slots[slot].surface==NULL)
+      return slot;
+    slot=(slot+1)%SPRITE_SLOTS;
+  }
+  return -1;
+}
+
+///////////////////////////////////
+/*  Compile a surface and keep   */
+/*  it for blit_sprite()         */
+///////////////////////////////////
+void sprite_register(SDL_Surface* src)
+{
+  if(!src)
+    return;
+  int slot=sprite_slot_of(src);
+  if(slot<0 || sprite_slots[slot].surface)
+    return;
+  span_sprite* sprite=sprite_compile(src);
+  if(!sprite)
+    return;
+  sprite_slots[slot].surface=src;
+  sprite_slots[slot].sprite=sprite;
+}
+
+///////////////////////////////////
+/*  Forget a surface before it's */
+/*  freed                        */
+///////////////////////////////////
+void sprite_unregister(SDL_Surface* src)
+{
+  int slot=sprite_slot_of(src);
+  if(slot<0 || !sprite_slots[slot].surface)
+    return;
+  sprite_free(sprite_slots[slot].sprite);
+  sprite_slots[slot].surface=NULL;
+  sprite_slots[slot].sprite=NULL;
+
+  // move back the next surfaces of the chain, so all are found again
+  int next=(slot+1)%SPRITE_SLOTS;
+  while(sprite_slots[next].surface)
+  {
+    sprite_slot moved=sprite_slots[next];
+    sprite_slots[next].surface=NULL;
+    sprite_slots[next].sprite=NULL;
+    sprite_slots[sprite_slot_of(moved.surface)]=moved;
+    next=(next+1)%SPRITE_SLOTS;
+  }
+}
+
+///////////////////////////////////
+/*  Compiled sprite of a surface */
+///////////////////////////////////
+span_sprite* sprite_find(SDL_Surface* src)
+{
+  int slot=sprite_slot_of(src);
+  if(slot<0 || !sprite_slots[slot].surface)
+    return NULL;
+  return sprite_slots[slot].sprite;
+}
+
+///////////////////////////////////
+/*  Free all compiled sprites    */
+///////////////////////////////////
+void sprite_unregister_all()
+{
+  for(int f=0;f<SPRITE_SLOTS;f++)
+  {
+    sprite_free(sprite_slots[f].sprite);
+    sprite_slots[f].surface=NULL;
+    sprite_slots[f].sprite=NULL;
+  }
+}
+
+///////////////////////////////////
+/*  List registered surfaces     */
+///////////////////////////////////
+int sprite_registered(SDL_Surface** list, int max)
+{
+  int count=0;
+  for(int f=0;f<SPRITE_SLOTS && count<max;f++)
+    if(sprite_slots[f].surface)
+      list[count++]=sprite_slots[f].surface;
+  return count;
+}
+
+///////////////////////////////////
+/*  Draw a surface, with spans   */
+/*  if it was registered         */
+///////////////////////////////////
+void blit_sprite(SDL_Surface* src, SDL_Surface* dst, SDL_Rect* dest)
+{
+  if(!src)
+    return;
+  span_sprite* sprite=sprite_find(src);
+  if(sprite && sprite_draw(sprite,dst,dest->x,dest->y))
+    return;
+  SDL_BlitSurface(src,NULL,dst,dest);
+}
@@ -0,0 +1,49 @@
+/*
+  RG350 Test
+  Colorkey sprites compiled to lists of opaque spans. Drawing a sprite
+  copies every span with memcpy, without testing the colorkey of every
+  pixel.
+*/
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct sprite_span
+{
+  Uint16 x;           // first pixel in the row
+  Uint16 len;         // opaque pixels
+  Uint32 offset;      // first pixel in sprite pixels
+};
+
+struct span_sprite
+{
+  int w,h;
+  int bpp;            // bytes per pixel, 2 or 4
+  Uint8* pixels;      // opaque pixels, one span after another
+  sprite_span* spans;
+  int* row_start;     // first span of every row, h+1 items
+  Uint32 Rmask,Gmask,Bmask;   // destination must have the same format
+};
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+span_sprite* sprite_compile(SDL_Surface* src);
+void sprite_free(span_sprite* sprite);
+int sprite_draw(span_sprite* sprite, SDL_Surface* dst, int x, int y);
+void sprite_register(SDL_Surface* src);
+void sprite_unregister(SDL_Surface* src);
+span_sprite* sprite_find(SDL_Surface* src);
+void sprite_unregister_all();
+int sprite_registered(SDL_Surface** list, int max);
+void blit_sprite(SDL_Surface* src, SDL_Surface* dst, SDL_Rect* dest);
+
+#endif
@@ -0,0 +1,366 @@
+/*
+  RG350 Test
+  Music streamed from the SD card: a thread reads the file ahead into a
+  ring and SDL_mixer decodes it from there, so the load of background
+  music of real apps can be measured while the app keeps working.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+#include "timing.h"
+#include "audio.h"
+#include "stream.h"
+
+#define STREAM_RING      (256*1024)   // bytes read ahead
+#define STREAM_CHUNK     (16*1024)    // bytes of every read
+#define STREAM_HISTORY   (4*1024)     // bytes kept behind, decoders seek back a little
+#define STREAM_PREFETCH  (64*1024)    // bytes read before decoding
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct stream_ring
+{
+  Uint8* data;
+  int fd;
+  long long size;           // of the file
+  // offsets in the file: [begin,end) is in the ring, pos is the next byte decoded
+  long long begin,end,pos;
+  int restart;              // seek out of the ring, reader starts again at end
+  int quit;
+  unsigned long long read_bytes;
+  unsigned long long read_us;
+  unsigned long long taken;  // bytes given to the decoder
+  unsigned int stalls;
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+stream_stats stream_results;
+
+static const char* stream_paths[]={
+  "/media/sdcard/rg350test/stream.ogg",
+  "/media/sdcard/rg350test/stream.mp3",
+  "media/stream.mp3"
+};
+#define STREAM_PATHS  (int)(sizeof(stream_paths)/sizeof(stream_paths[0]))
+
+static stream_ring ring;
+static pthread_t stream_th;
+static pthread_mutex_t stream_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stream_cond=PTHREAD_COND_INITIALIZER;
+static SDL_RWops* stream_rw=NULL;
+static Mix_Music* stream_music=NULL;
+static volatile int stream_tid=0;       // audio thread, set by the postmix hook
+static unsigned long stream_ticks=0;     // cpu ticks of the audio thread
+static unsigned long long stream_time=0;
+static unsigned long long stream_lastread=0;
+static unsigned long long stream_lastread_us=0;
+static unsigned long long stream_lasttaken=0;
+
+///////////////////////////////////
+/*  Thread that reads the file   */
+/*  ahead                        */
+///////////////////////////////////
+static void* stream_thd(void* p)
+{
+  pthread_mutex_lock(&stream_mutex);
+  while(!ring.quit)
+  {
+    if(ring.restart)
+    {
+      lseek(ring.fd,ring.end,SEEK_SET);
+      ring.restart=0;
+    }
+    // room for a chunk, without losing the history of the decoder
+    if(ring.end>=ring.size || ring.end-ring.pos+STREAM_CHUNK>STREAM_RING-STREAM_HISTORY)
+    {
+      pthread_cond_wait(&stream_cond,&stream_mutex);
+      continue;
+    }
+    long long at=ring.end;
+    int offset=at%STREAM_RING;
+    int len=STREAM_CHUNK;
+    if(len>STREAM_RING-offset)
+      len=STREAM_RING-offset;
+    // bytes that will be overwritten leave the ring now
+    if(ring.begin<at+len-STREAM_RING)
+      ring.begin=at+len-STREAM_RING;
+    pthread_mutex_unlock(&stream_mutex);
+
+    unsigned long long start=time_us();
+    int bytes=read(ring.fd,ring.data+offset,len);
+    unsigned long long elapsed=time_us()-start;
+
+    pthread_mutex_lock(&stream_mutex);
+    // a seek out of the ring while reading, the bytes aren't valid
+    if(ring.restart)
+      continue;
+    if(bytes<=0)
+    {
+      // the file is shorter than it was
+      ring.size=ring.end;
+      pthread_cond_broadcast(&stream_cond);
+      continue;
+    }
+    ring.end+=bytes;
+    ring.read_bytes+=bytes;
+    ring.read_us+=elapsed;
+    pthread_cond_broadcast(&stream_cond);
+  }
+  pthread_mutex_unlock(&stream_mutex);
+  return NULL;
+}
+
+///////////////////////////////////
+/*  SDL_RWops of the ring, the   */
+/*  decoder waits if the reader  */
+/*  is behind                    */
+///////////////////////////////////
+static int stream_rwread(SDL_RWops* context, void* ptr, int size, int maxnum)
+{
+  int wanted=size*maxnum;
+  int done=0;
+  if(size<=0)
+    return 0;
+
+  pthread_mutex_lock(&stream_mutex);
+  while(done<wanted)
+  {
+    if(ring.pos>=ring.end)
+    {
+      if(ring.pos>=ring.size || ring.quit)
+        break;
+      ring.stalls++;
+      pthread_cond_wait(&stream_cond,&stream_mutex);
+      continue;
+    }
+    int offset=ring.pos%STREAM_RING;
+    long long len=ring.end-ring.pos;
+    if(len>STREAM_RING-offset)
+      len=STREAM_RING-offset;
+    if(len>wanted-done)
+      len=wanted-done;
+    memcpy((Uint8*)ptr+done,ring.data+offset,len);
+    ring.pos+=len;
+    ring.taken+=len;
+    done+=len;
+  }
+  pthread_cond_broadcast(&stream_cond);
+  pthread_mutex_unlock(&stream_mutex);
+  return done/size;
+}
+
+static int stream_rwseek(SDL_RWops* context, int offset, int whence)
+{
+  pthread_mutex_lock(&stream_mutex);
+  long long pos=offset;
+  if(whence==SEEK_CUR)
+    pos+=ring.pos;
+  else if(whence==SEEK_END)
+    pos+=ring.size;
+  if(pos<0)
+    pos=0;
+  if(pos>ring.size)
+    pos=ring.size;
+
+  if(pos>=ring.begin && pos<=ring.end)
+    ring.pos=pos;
+  else
+  {
+    // out of the ring, read again from there
+    ring.begin=ring.end=ring.pos=pos;
+    ring.restart=1;
+    pthread_cond_broadcast(&stream_cond);
+  }
+  pthread_mutex_unlock(&stream_mutex);
+  return (int)pos;
+}
+
+static int stream_rwwrite(SDL_RWops* context, const void* ptr, int size, int num)
+{
+  return -1;
+}
+
+static int stream_rwclose(SDL_RWops* context)
+{
+  return 0;
+}
+
+///////////////////////////////////
+/*  Thread id of the audio       */
+/*  thread, it decodes the music */
+///////////////////////////////////
+static void stream_hook(void* udata, Uint8* stream, int len)
+{
+  stream_tid=syscall(SYS_gettid);
+}
+
+///////////////////////////////////
+/*  CPU ticks of a thread        */
+///////////////////////////////////
+static unsigned long stream_threadticks(int tid)
+{
+  char path[64];
+  char line[512];
+  unsigned long utime=0,stime=0;
+
+  snprintf(path,sizeof(path),"/proc/self/task/%d/stat",tid);
+  FILE* fd=fopen(path,"r");
+  if(!fd)
+    return 0;
+  if(fgets(line,sizeof(line),fd))
+  {
+    // the name can have spaces, fields start after ')'
+    char* fields=strrchr(line,')');
+    if(fields)
+      sscanf(fields+1," %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",&utime,&stime);
+  }
+  fclose(fd);
+  return utime+stime;
+}
+
+///////////////////////////////////
+/*  Start the music              */
+///////////////////////////////////
+void stream_start()
+{
+  struct stat info;
+  int f;
+
+  stream_stop();
+  memset(&stream_results,0,sizeof(stream_results));
+  memset(&ring,0,sizeof(ring));
+  ring.fd=-1;
+  for(f=0;f<STREAM_PATHS && ring.fd<0;f++)
+  {
+    ring.fd=open(stream_paths[f],O_RDONLY);
+    stream_results.path=stream_paths[f];
+  }
+  if(ring.fd<0 || fstat(ring.fd,&info)<0 || !audio.opened)
+  {
+    if(ring.fd>=0)
+      close(ring.fd);
+    stream_results.status=2;
+    return;
+  }
+  ring.size=info.st_size;
+  ring.data=(Uint8*)malloc(STREAM_RING);
+  if(!ring.data)
+  {
+    close(ring.fd);
+    stream_results.status=2;
+    return;
+  }
+  pthread_create(&stream_th,NULL,stream_thd,NULL);
+
+  // some data before the decoder looks at the file
+  pthread_mutex_lock(&stream_mutex);
+  while(ring.end<STREAM_PREFETCH && ring.end<ring.size)
+    pthread_cond_wait(&stream_cond,&stream_mutex);
+  pthread_mutex_unlock(&stream_mutex);
+
+  stream_rw=SDL_AllocRW();
+  if(stream_rw)
+  {
+    stream_rw->read=stream_rwread;
+    stream_rw->seek=stream_rwseek;
+    stream_rw->write=stream_rwwrite;
+    stream_rw->close=stream_rwclose;
+    stream_music=Mix_LoadMUS_RW(stream_rw);
+  }
+  if(!stream_music || Mix_PlayMusic(stream_music,-1)<0)
+  {
+    stream_stop();
+    stream_results.status=3;
+    return;
+  }
+  stream_tid=0;
+  stream_ticks=0;
+  stream_time=time_us();
+  stream_lastread=0;
+  stream_lastread_us=0;
+  stream_lasttaken=0;
+  audio_addhook(stream_hook,NULL);
+  stream_results.status=1;
+}
+
+///////////////////////////////////
+/*  Called every frame, update   */
+/*  the stats every second       */
+///////////////////////////////////
+void stream_update()
+{
+  if(stream_results.status!=1)
+    return;
+
+  pthread_mutex_lock(&stream_mutex);
+  long long ahead=ring.end-ring.pos;
+  unsigned long long read_bytes=ring.read_bytes;
+  unsigned long long read_us=ring.read_us;
+  unsigned long long taken=ring.taken;
+  stream_results.stalls=ring.stalls;
+  pthread_mutex_unlock(&stream_mutex);
+  // a short file is all in the ring
+  long long most=ring.size<STREAM_RING-STREAM_HISTORY?ring.size:STREAM_RING-STREAM_HISTORY;
+  stream_results.fill=most>0?ahead*100.0/most:0;
+
+  unsigned long long now=time_us();
+  unsigned long long elapsed=now-stream_time;
+  if(elapsed<1000000 || !stream_tid)
+    return;
+  unsigned long ticks=stream_threadticks(stream_tid);
+  if(stream_ticks)
+    stream_results.cpu=(ticks-stream_ticks)*100.0/sysconf(_SC_CLK_TCK)/(elapsed/1000000.0);
+  stream_ticks=ticks;
+  if(read_us>stream_lastread_us)
+    stream_results.read_mbs=(read_bytes-stream_lastread)/(double)(read_us-stream_lastread_us);
+  stream_results.stream_kbs=(taken-stream_lasttaken)*1000.0/1024/elapsed;
+  stream_lastread=read_bytes;
+  stream_lastread_us=read_us;
+  stream_lasttaken=taken;
+  stream_time=now;
+}
+
+///////////////////////////////////
+/*  Stop the music and the       */
+/*  reader                       */
+///////////////////////////////////
+void stream_stop()
+{
+  if(!ring.data)
+    return;
+  audio_removehook(stream_hook);
+  if(stream_music)
+  {
+    Mix_HaltMusic();
+    Mix_FreeMusic(stream_music);
+    stream_music=NULL;
+  }
+  pthread_mutex_lock(&stream_mutex);
+  ring.quit=1;
+  pthread_cond_broadcast(&stream_cond);
+  pthread_mutex_unlock(&stream_mutex);
+  pthread_join(stream_th,NULL);
+  if(stream_rw)
+  {
+    SDL_FreeRW(stream_rw);
+    stream_rw=NULL;
+  }
+  close(ring.fd);
+  free(ring.data);
+  ring.data=NULL;
+  stream_results.status=0;
+}
@@ -0,0 +1,37 @@
+/*
+  RG350 Test
+  Music streamed from the SD card: a thread reads the file ahead into a
+  ring and SDL_mixer decodes it from there, so the load of background
+  music of real apps can be measured while the app keeps working.
+*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct stream_stats
+{
+  int status;             // 0=stopped, 1=playing, 2=file not found, 3=can't decode
+  const char* path;
+  double cpu;             // % of the audio thread, decoding and mixing
+  double fill;            // % of the ring read ahead
+  double read_mbs;        // MB/s of the reads of the file
+  double stream_kbs;      // kB/s taken by the decoder
+  unsigned int stalls;    // decoder waited for the file
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern stream_stats stream_results;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void stream_start();
+void stream_update();
+void stream_stop();
+
+#endif
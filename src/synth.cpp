@@ -0,0 +1,227 @@
+/*
+  RG350 Test
+  Audio test generator hooked to the mixer: sine sweep, tone in one
+  channel, pink noise and polarity test, synthesized while playing.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <math.h>
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+#include "synth.h"
+
+#define SYNTH_TABLEBITS   10                // sine table of 1024 values
+#define SYNTH_TABLESIZE   (1<<SYNTH_TABLEBITS)
+#define SYNTH_AMPLITUDE   8192              // -12 dBFS
+#define SYNTH_SWEEPTIME   10                // seconds from 20 Hz to the end
+#define SYNTH_SWEEPSTART  20
+#define SYNTH_SWEEPEND    20000             // lowered to 0.45 of the rate, under Nyquist
+#define SYNTH_SWEEPSTEP   64                // samples between frequency changes
+#define SYNTH_TONE        1000
+#define SYNTH_LOWTONE     200
+#define SYNTH_PINKGAIN    901               // 0.11 of Paul Kellet filter, and -12 dB
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct synth_state
+{
+  int mode;
+  int playing;
+  int rate;               // samples per second of the mixer
+  int channels;
+  Uint32 phase;           // 32 bit phase, the upper bits index the table
+  Uint32 step;            // phase added every sample
+  Uint32 sweep_ratio;     // step multiplier every SYNTH_SWEEPSTEP samples, 8.24
+  Uint32 sweep_end;       // step of the last frequency
+  Uint32 samples;         // samples played
+  Uint32 noise;           // random generator
+  Sint32 pink[7];         // pink noise filter
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+const char* synth_names[SYNTH_MODES]={"sweep","left","right","pink noise","polarity"};
+static Sint16 synth_sine[SYNTH_TABLESIZE];
+static synth_state synth;
+
+///////////////////////////////////
+/*  Phase step of a frequency    */
+///////////////////////////////////
+static Uint32 synth_step(double freq)
+{
+  return (Uint32)(freq*4294967296.0/synth.rate);
+}
+
+///////////////////////////////////
+/*  Next sine value              */
+///////////////////////////////////
+static inline Sint32 synth_sinevalue()
+{
+  Sint32 value=synth_sine[synth.phase>>(32-SYNTH_TABLEBITS)];
+  synth.phase+=synth.step;
+  return value;
+}
+
+///////////////////////////////////
+/*  Next pink noise value, white */
+/*  noise filtered -3 dB/octave  */
+///////////////////////////////////
+static inline Sint32 synth_pinkvalue()
+{
+  // xorshift, white noise of 16 bits
+  synth.noise^=synth.noise<<13;
+  synth.noise^=synth.noise>>17;
+  synth.noise^=synth.noise<<5;
+  Sint32 white=(Sint32)(synth.noise>>16)-32768;
+
+  // Paul Kellet filter, coefficients in 1.15 fixed point
+  Sint32* b=synth.pink;
+  b[0]=(Sint32)((32731LL*b[0]+white*1819LL)>>15);
+  b[1]=(Sint32)((32549LL*b[1]+white*2460LL)>>15);
+  b[2]=(Sint32)((31752LL*b[2]+white*5041LL)>>15);
+  b[3]=(Sint32)((28394LL*b[3]+white*10174LL)>>15);
+  b[4]=(Sint32)((18022LL*b[4]+white*17464LL)>>15);
+  b[5]=(Sint32)((-24956LL*b[5]-white*554LL)>>15);
+  Sint32 pink=b[0]+b[1]+b[2]+b[3]+b[4]+b[5]+b[6]+((white*17570)>>15);
+  b[6]=(white*3799)>>15;
+  return (pink*SYNTH_PINKGAIN)>>15;
+}
+
+///////////////////////////////////
+/*  Mixer callback, fills the    */
+/*  buffer without allocations   */
+///////////////////////////////////
+static void synth_callback(void* udata, Uint8* stream, int len)
+{
+  Sint16* out=(Sint16*)stream;
+  int frames=len/(2*synth.channels);
+
+  for(int f=0;f<frames;f++)
+  {
+    Sint32 left=0,right=0;
+    switch(synth.mode)
+    {
+      case SYNTH_SWEEP:
+        left=right=synth_sinevalue();
+        if(synth.samples%SYNTH_SWEEPSTEP==0)
+        {
+          synth.step=(Uint32)(((unsigned long long)synth.step*synth.sweep_ratio)>>24);
+          if(synth.step>synth.sweep_end)
+            synth.step=synth_step(SYNTH_SWEEPSTART);
+        }
+        break;
+      case SYNTH_LEFT:
+        left=synth_sinevalue();
+        break;
+      case SYNTH_RIGHT:
+        right=synth_sinevalue();
+        break;
+      case SYNTH_PINK:
+        left=right=synth_pinkvalue();
+        break;
+      case SYNTH_POLARITY:
+        left=synth_sinevalue();
+        // odd seconds the right channel is inverted
+        right=((synth.samples/synth.rate)&1)?-left:left;
+        break;
+    }
+    synth.samples++;
+
+    if(left>32767)
+      left=32767;
+    if(left<-32768)
+      left=-32768;
+    if(right>32767)
+      right=32767;
+    if(right<-32768)
+      right=-32768;
+    if(synth.channels==1)
+      *out++=(Sint16)((left+right)/2);
+    else
+    {
+      *out++=(Sint16)left;
+      *out++=(Sint16)right;
+      for(int c=2;c<synth.channels;c++)
+        *out++=0;
+    }
+  }
+}
+
+///////////////////////////////////
+/*  Build the sine table         */
+///////////////////////////////////
+void synth_init()
+{
+  for(int f=0;f<SYNTH_TABLESIZE;f++)
+    synth_sine[f]=(Sint16)(sin(f*2*M_PI/SYNTH_TABLESIZE)*SYNTH_AMPLITUDE);
+  synth.noise=0x12345678;
+}
+
+///////////////////////////////////
+/*  Start a test sound           */
+///////////////////////////////////
+void synth_play(int mode)
+{
+  Uint16 format;
+  synth_stop();
+  if(!Mix_QuerySpec(&synth.rate,&format,&synth.channels) || format!=AUDIO_S16SYS)
+    return;
+
+  synth.mode=mode;
+  synth.phase=0;
+  synth.samples=0;
+  for(int f=0;f<7;f++)
+    synth.pink[f]=0;
+  switch(mode)
+  {
+    case SYNTH_SWEEP:
+    {
+      // above half the rate the sweep folds back as false tones
+      double end=synth.rate*0.45<SYNTH_SWEEPEND?synth.rate*0.45:SYNTH_SWEEPEND;
+      synth.step=synth_step(SYNTH_SWEEPSTART);
+      synth.sweep_end=synth_step(end);
+      // from start to end in SYNTH_SWEEPTIME seconds
+      synth.sweep_ratio=(Uint32)(pow(end/SYNTH_SWEEPSTART,(double)SYNTH_SWEEPSTEP/(synth.rate*SYNTH_SWEEPTIME))*16777216+0.5);
+      break;
+    }
+    case SYNTH_POLARITY:
+      synth.step=synth_step(SYNTH_LOWTONE);
+      break;
+    default:
+      synth.step=synth_step(SYNTH_TONE);
+      break;
+  }
+  synth.playing=1;
+  Mix_HookMusic(synth_callback,NULL);
+}
+
+///////////////////////////////////
+/*  Stop the test sound          */
+///////////////////////////////////
+void synth_stop()
+{
+  if(!synth.playing)
+    return;
+  Mix_HookMusic(NULL,NULL);
+  synth.playing=0;
+}
+
+///////////////////////////////////
+/*  Is a test sound playing      */
+///////////////////////////////////
+int synth_playing()
+{
+  return synth.playing;
+}
+
+///////////////////////////////////
+/*  Mode of the last test sound  */
+///////////////////////////////////
+int synth_mode()
+{
+  return synth.mode;
+}
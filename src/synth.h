@@ -0,0 +1,31 @@
+/*
+  RG350 Test
+  Audio test generator hooked to the mixer: sine sweep, tone in one
+  channel, pink noise and polarity test, synthesized while playing.
+*/
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#define SYNTH_SWEEP     0   // 20 Hz to 20 kHz or 0.45 of the rate, both channels
+#define SYNTH_LEFT      1   // 1 kHz, left channel
+#define SYNTH_RIGHT     2   // 1 kHz, right channel
+#define SYNTH_PINK      3   // pink noise, both channels
+#define SYNTH_POLARITY  4   // 200 Hz, channels in phase and inverted every second
+#define SYNTH_MODES     5
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern const char* synth_names[SYNTH_MODES];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void synth_init();
+void synth_play(int mode);
+void synth_stop();
+int synth_playing();
+int synth_mode();
+
+#endif
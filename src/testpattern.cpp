@@ -0,0 +1,212 @@
+/*
+  RG350 Test
+  Display test patterns: solid colors for dead pixels, gradients for
+  banding, checkerboards, grey ramps and a moving block for ghosting.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <string.h>
+#include "testpattern.h"
+
+#define PATTERN_RED        0
+#define PATTERN_GREEN      1
+#define PATTERN_BLUE       2
+#define PATTERN_WHITE      3
+#define PATTERN_BLACK      4
+#define PATTERN_GRADIENTS  5
+#define PATTERN_GREYSTEPS  6
+#define PATTERN_GREYRAMP   7
+#define PATTERN_CHECKER1   8
+#define PATTERN_CHECKER8   9
+#define PATTERN_BLOCK      10
+
+#define PATTERN_BLOCKSIZE  40
+#define PATTERN_BLOCKSPEED 4   // pixels every frame
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+const char* pattern_names[PATTERN_COUNT]={
+  "Red","Green","Blue","White","Black","Gradients","Grey steps","Grey ramp",
+  "Checkerboard 1 px","Checkerboard 8 px","Moving block"
+};
+
+///////////////////////////////////
+/*  Two RGB565 pixels in a word, */
+/*  first pixel at lower address */
+///////////////////////////////////
+static inline Uint32 pattern_pair(Uint32 first, Uint32 second)
+{
+#if SDL_BYTEORDER==SDL_LIL_ENDIAN
+  return first | second<<16;
+#else
+  return first<<16 | second;
+#endif
+}
+
+///////////////////////////////////
+/*  Fill pixels x0 to x1 of a    */
+/*  row, even pixels c0 and odd  */
+/*  pixels c1                    */
+///////////////////////////////////
+static void pattern_span(SDL_Surface* dst, Uint8* row, int x0, int x1, Uint32 c0, Uint32 c1)
+{
+  int x=x0;
+  if(dst->format->BytesPerPixel==2)
+  {
+    Uint16* pixels=(Uint16*)row;
+    // 16 bit stores until the word is aligned, then two pixels every store
+    while(x<x1 && ((unsigned long)(pixels+x)&3))
+    {
+      pixels[x]=(x&1)?c1:c0;
+      x++;
+    }
+    Uint32 pair=(x&1)?pattern_pair(c1,c0):pattern_pair(c0,c1);
+    Uint32* words=(Uint32*)(pixels+x);
+    int count=(x1-x)/2;
+    for(int f=0;f<count;f++)
+      words[f]=pair;
+    for(x+=count*2;x<x1;x++)
+      pixels[x]=(x&1)?c1:c0;
+  }
+  else if(dst->format->BytesPerPixel==4)
+  {
+    Uint32* pixels=(Uint32*)row;
+    for(;x<x1;x++)
+      pixels[x]=(x&1)?c1:c0;
+  }
+}
+
+///////////////////////////////////
+/*  Copy a row to the next rows  */
+///////////////////////////////////
+static void pattern_copyrow(SDL_Surface* dst, int y, int rows)
+{
+  Uint8* src=(Uint8*)dst->pixels+y*dst->pitch;
+  int bytes=dst->w*dst->format->BytesPerPixel;
+  for(int f=1;f<rows && y+f<dst->h;f++)
+    memcpy(src+f*dst->pitch,src,bytes);
+}
+
+///////////////////////////////////
+/*  Row of solid steps from      */
+/*  black to a color             */
+///////////////////////////////////
+static void pattern_ramp(SDL_Surface* dst, int y, int rows, int levels, int r, int g, int b)
+{
+  Uint8* row=(Uint8*)dst->pixels+y*dst->pitch;
+  for(int f=0;f<levels;f++)
+  {
+    int value=f*255/(levels-1);
+    Uint32 color=SDL_MapRGB(dst->format,r*value/255,g*value/255,b*value/255);
+    pattern_span(dst,row,f*dst->w/levels,(f+1)*dst->w/levels,color,color);
+  }
+  pattern_copyrow(dst,y,rows);
+}
+
+///////////////////////////////////
+/*  Levels of a color channel    */
+///////////////////////////////////
+static int pattern_levels(Uint8 loss)
+{
+  return 256>>loss;
+}
+
+///////////////////////////////////
+/*  Draw a pattern on the whole  */
+/*  surface                      */
+///////////////////////////////////
+void pattern_draw(SDL_Surface* dst, int pattern, int frame)
+{
+  SDL_PixelFormat* format=dst->format;
+  Uint32 white=SDL_MapRGB(format,255,255,255);
+  Uint32 black=SDL_MapRGB(format,0,0,0);
+  Uint32 solid=black;
+  int band=dst->h/4;
+  int x,y;
+
+  if(SDL_MUSTLOCK(dst) && SDL_LockSurface(dst)<0)
+    return;
+  Uint8* pixels=(Uint8*)dst->pixels;
+
+  switch(pattern)
+  {
+    case PATTERN_RED:
+      solid=SDL_MapRGB(format,255,0,0);
+      break;
+    case PATTERN_GREEN:
+      solid=SDL_MapRGB(format,0,255,0);
+      break;
+    case PATTERN_BLUE:
+      solid=SDL_MapRGB(format,0,0,255);
+      break;
+    case PATTERN_WHITE:
+      solid=white;
+      break;
+    case PATTERN_GRADIENTS:
+      // every level of the channel, so banding is the panel and not the pattern
+      pattern_ramp(dst,0,band,pattern_levels(format->Rloss),255,0,0);
+      pattern_ramp(dst,band,band,pattern_levels(format->Gloss),0,255,0);
+      pattern_ramp(dst,band*2,band,pattern_levels(format->Bloss),0,0,255);
+      pattern_ramp(dst,band*3,dst->h-band*3,pattern_levels(format->Rloss),255,255,255);
+      break;
+    case PATTERN_GREYSTEPS:
+      pattern_ramp(dst,0,dst->h,16,255,255,255);
+      break;
+    case PATTERN_GREYRAMP:
+      pattern_ramp(dst,0,dst->h/2,pattern_levels(format->Rloss),255,255,255);
+      // bottom half from white to black, the two halves meet at the ends
+      for(x=0;x<dst->w;x++)
+        memcpy(pixels+(dst->h/2)*dst->pitch+x*format->BytesPerPixel,pixels+(dst->w-1-x)*format->BytesPerPixel,format->BytesPerPixel);
+      pattern_copyrow(dst,dst->h/2,dst->h-dst->h/2);
+      break;
+    case PATTERN_CHECKER1:
+      pattern_span(dst,pixels,0,dst->w,white,black);
+      pattern_span(dst,pixels+dst->pitch,0,dst->w,black,white);
+      for(y=2;y<dst->h;y++)
+        memcpy(pixels+y*dst->pitch,pixels+(y&1)*dst->pitch,dst->w*format->BytesPerPixel);
+      break;
+    case PATTERN_CHECKER8:
+      for(y=0;y<dst->h;y+=8)
+      {
+        Uint8* row=pixels+y*dst->pitch;
+        for(x=0;x<dst->w;x+=8)
+        {
+          Uint32 color=((x^y)&8)?black:white;
+          pattern_span(dst,row,x,x+8<dst->w?x+8:dst->w,color,color);
+        }
+        pattern_copyrow(dst,y,8);
+      }
+      break;
+    case PATTERN_BLOCK:
+    {
+      int left=(frame*PATTERN_BLOCKSPEED)%(dst->w+PATTERN_BLOCKSIZE)-PATTERN_BLOCKSIZE;
+      int right=left+PATTERN_BLOCKSIZE;
+      int top=(dst->h-PATTERN_BLOCKSIZE)/2;
+      if(top<0)
+        top=0;
+      if(left<0)
+        left=0;
+      if(right>dst->w)
+        right=dst->w;
+      pattern_span(dst,pixels,0,dst->w,black,black);
+      pattern_copyrow(dst,0,dst->h);
+      if(left<right)
+      {
+        pattern_span(dst,pixels+top*dst->pitch,left,right,white,white);
+        pattern_copyrow(dst,top,PATTERN_BLOCKSIZE);
+      }
+      break;
+    }
+  }
+
+  if(pattern<=PATTERN_BLACK)
+  {
+    pattern_span(dst,pixels,0,dst->w,solid,solid);
+    pattern_copyrow(dst,0,dst->h);
+  }
+  if(SDL_MUSTLOCK(dst))
+    SDL_UnlockSurface(dst);
+}
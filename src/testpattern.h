@@ -0,0 +1,27 @@
+/*
+  RG350 Test
+  Display test patterns: solid colors for dead pixels, gradients for
+  banding, checkerboards, grey ramps and a moving block for ghosting.
+*/
+
+#ifndef TESTPATTERN_H
+#define TESTPATTERN_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define PATTERN_COUNT  11
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern const char* pattern_names[PATTERN_COUNT];
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void pattern_draw(SDL_Surface* dst, int pattern, int frame);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+  RG350 Test
+  Clocks used to measure tests and to pace frames. SDL_GetTicks() only
+  has ms resolution.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <time.h>
+#include <errno.h>
+#include "timing.h"
+
+///////////////////////////////////
+/*  Monotonic time in us         */
+///////////////////////////////////
+unsigned long long time_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+///////////////////////////////////
+/*  CPU time used by the process */
+/*  in us                        */
+///////////////////////////////////
+unsigned long long cputime_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+  return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+///////////////////////////////////
+/*  CPU time used by the calling */
+/*  thread in us                 */
+///////////////////////////////////
+unsigned long long threadtime_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+  return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+///////////////////////////////////
+/*  Start pacing frames from now */
+///////////////////////////////////
+void pacer_start(frame_pacer& pacer, long period_ns)
+{
+  pacer.period_ns=period_ns;
+  clock_gettime(CLOCK_MONOTONIC,&pacer.deadline);
+}
+
+///////////////////////////////////
+/*  Sleep until the end of the   */
+/*  frame. Deadlines are added,  */
+/*  so sleep errors don't        */
+/*  accumulate                   */
+///////////////////////////////////
+void pacer_wait(frame_pacer& pacer)
+{
+  struct timespec now;
+
+  pacer.deadline.tv_nsec+=pacer.period_ns;
+  while(pacer.deadline.tv_nsec>=1000000000L)
+  {
+    pacer.deadline.tv_sec++;
+    pacer.deadline.tv_nsec-=1000000000L;
+  }
+  // more than a frame late, start again from now instead of running frames without sleep
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  long long late=(long long)(now.tv_sec-pacer.deadline.tv_sec)*1000000000LL+(now.tv_nsec-pacer.deadline.tv_nsec);
+  if(late>pacer.period_ns)
+  {
+    pacer.deadline=now;
+    return;
+  }
+  while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&pacer.deadline,NULL)==EINTR)
+    ;
+}
@@ -0,0 +1,33 @@
+/*
+  RG350 Test
+  Clocks used to measure tests and to pace frames. SDL_GetTicks() only
+  has ms resolution.
+*/
+
+#ifndef TIMING_H
+#define TIMING_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <time.h>
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct frame_pacer
+{
+  struct timespec deadline;   // end of the current frame
+  long period_ns;
+};
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+unsigned long long time_us();
+unsigned long long cputime_us();
+unsigned long long threadtime_us();
+void pacer_start(frame_pacer& pacer, long period_ns);
+void pacer_wait(frame_pacer& pacer);
+
+#endif
@@ -0,0 +1,219 @@
+/*
+  RG350 Test
+  Video benchmarks: fills, blit paths and framebuffer copies measured
+  in Mpixels/s with the sprites loaded by the app, on the screen and
+  on hardware and software surfaces of 16 and 32 bpp.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timing.h"
+#include "sprite.h"
+#include "videobench.h"
+
+#define VIDEOBENCH_TIME     200   // ms measuring every path
+#define VIDEOBENCH_SPRITES  128
+
+#define BLIT_SDL        0   // SDL_BlitSurface, the flags of the sprite choose the path
+#define BLIT_SPANS      1   // compiled sprites
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+video_bench video_results;
+
+///////////////////////////////////
+/*  Save a result                */
+///////////////////////////////////
+static void videobench_add(const char* test, const char* target, double mpixels)
+{
+  if(video_results.count>=VIDEOBENCH_MAX)
+    return;
+  videobench_result& result=video_results.results[video_results.count];
+  snprintf(result.name,sizeof(result.name),"%s %s",test,target);
+  result.mpixels=mpixels;
+  video_results.count++;
+}
+
+///////////////////////////////////
+/*  Fill the target until time   */
+/*  is over, return Mpixels/s    */
+///////////////////////////////////
+static double videobench_fill(SDL_Surface* target)
+{
+  double pixels=0;
+  Uint32 color=0;
+  unsigned long long start=time_us();
+  unsigned long long elapsed=0;
+
+  while(elapsed<VIDEOBENCH_TIME*1000)
+  {
+    SDL_FillRect(target,NULL,color);
+    color+=0x010101;
+    pixels+=target->w*target->h;
+    elapsed=time_us()-start;
+  }
+  return pixels/elapsed;
+}
+
+///////////////////////////////////
+/*  Copy a whole frame into the  */
+/*  target until time is over    */
+///////////////////////////////////
+static double videobench_memcpy(SDL_Surface* target)
+{
+  int row_bytes=target->w*target->format->BytesPerPixel;
+  Uint8* frame=(Uint8*)malloc(row_bytes*target->h);
+  if(!frame)
+    return 0;
+  memset(frame,0x55,row_bytes*target->h);
+
+  double pixels=0;
+  unsigned long long start=time_us();
+  unsigned long long elapsed=0;
+  while(elapsed<VIDEOBENCH_TIME*1000)
+  {
+    if(SDL_MUSTLOCK(target) && SDL_LockSurface(target)<0)
+      break;
+    if(target->pitch==row_bytes)
+      memcpy(target->pixels,frame,row_bytes*target->h);
+    else
+      for(int y=0;y<target->h;y++)
+        memcpy((Uint8*)target->pixels+y*target->pitch,frame+y*row_bytes,row_bytes);
+    if(SDL_MUSTLOCK(target))
+      SDL_UnlockSurface(target);
+    pixels+=target->w*target->h;
+    elapsed=time_us()-start;
+  }
+  free(frame);
+  return elapsed?pixels/elapsed:0;
+}
+
+///////////////////////////////////
+/*  Blit all the sprites over    */
+/*  the target until time is     */
+/*  over, return Mpixels/s       */
+///////////////////////////////////
+static double videobench_sprites(SDL_Surface* target, SDL_Surface** sprites, int count, int mode)
+{
+  if(count==0)
+    return 0;
+  if(mode==BLIT_SPANS && target->format->BytesPerPixel!=2)
+    return 0;
+
+  double pixels=0;
+  int x=0,y=0;
+  unsigned long long start=time_us();
+  unsigned long long elapsed=0;
+
+  while(elapsed<VIDEOBENCH_TIME*1000)
+  {
+    for(int f=0;f<count;f++)
+    {
+      SDL_Surface* sprite=sprites[f];
+      SDL_Rect dest;
+      dest.x=x;
+      dest.y=y;
+      if(mode==BLIT_SPANS)
+      {
+        // target with other RGB masks
+        if(!sprite_draw(sprite_find(sprite),target,x,y))
+          return 0;
+      }
+      else
+        SDL_BlitSurface(sprite,NULL,target,&dest);
+      pixels+=sprite->w*sprite->h;
+      // walk over the target, sprites always inside
+      x=(x+37)%(target->w/2);
+      y=(y+23)%(target->h/2);
+    }
+    elapsed=time_us()-start;
+  }
+  return pixels/elapsed;
+}
+
+///////////////////////////////////
+/*  Run all the tests on a       */
+/*  target                       */
+///////////////////////////////////
+static void videobench_target(SDL_Surface* target, const char* label, SDL_Surface** sprites, SDL_Surface** alpha, SDL_Surface** rle, int count)
+{
+  videobench_add("fill",label,videobench_fill(target));
+  videobench_add("colorkey",label,videobench_sprites(target,sprites,count,BLIT_SDL));
+  videobench_add("alpha",label,videobench_sprites(target,alpha,count,BLIT_SDL));
+  videobench_add("RLE",label,videobench_sprites(target,rle,count,BLIT_SDL));
+  videobench_add("spans",label,videobench_sprites(target,sprites,count,BLIT_SPANS));
+  videobench_add("memcpy",label,videobench_memcpy(target));
+}
+
+///////////////////////////////////
+/*  Run all benchmarks           */
+///////////////////////////////////
+void videobench_run(SDL_Surface* screen)
+{
+  SDL_Surface* sprites[VIDEOBENCH_SPRITES];
+  SDL_Surface* alpha[VIDEOBENCH_SPRITES];
+  SDL_Surface* rle[VIDEOBENCH_SPRITES];
+  int count=sprite_registered(sprites,VIDEOBENCH_SPRITES);
+  int copies=0;
+  int f;
+
+  video_results.count=0;
+
+  // copies of the sprites with half transparency and with RLE
+  for(f=0;f<count;f++)
+  {
+    alpha[copies]=SDL_ConvertSurface(sprites[f],sprites[f]->format,SDL_SWSURFACE);
+    rle[copies]=SDL_ConvertSurface(sprites[f],sprites[f]->format,SDL_SWSURFACE);
+    if(!alpha[copies] || !rle[copies])
+    {
+      if(alpha[copies])
+        SDL_FreeSurface(alpha[copies]);
+      if(rle[copies])
+        SDL_FreeSurface(rle[copies]);
+      continue;
+    }
+    SDL_SetColorKey(alpha[copies],SDL_SRCCOLORKEY,sprites[f]->format->colorkey);
+    SDL_SetAlpha(alpha[copies],SDL_SRCALPHA,128);
+    SDL_SetColorKey(rle[copies],SDL_SRCCOLORKEY | SDL_RLEACCEL,sprites[f]->format->colorkey);
+    sprites[copies]=sprites[f];
+    copies++;
+  }
+
+  // the screen (hardware, double buffer) and offscreen surfaces
+  SDL_PixelFormat* format=screen->format;
+  videobench_target(screen,"screen",sprites,alpha,rle,copies);
+
+  SDL_Surface* target=SDL_CreateRGBSurface(SDL_HWSURFACE,320,240,format->BitsPerPixel,format->Rmask,format->Gmask,format->Bmask,0);
+  if(target)
+  {
+    // without free video memory SDL gives a software surface
+    videobench_target(target,(target->flags & SDL_HWSURFACE)?"hw":"hw(sw)",sprites,alpha,rle,copies);
+    SDL_FreeSurface(target);
+  }
+
+  target=SDL_CreateRGBSurface(SDL_SWSURFACE,320,240,16,0xF800,0x07E0,0x001F,0);
+  if(target)
+  {
+    videobench_target(target,"sw16",sprites,alpha,rle,copies);
+    SDL_FreeSurface(target);
+  }
+
+  target=SDL_CreateRGBSurface(SDL_SWSURFACE,320,240,32,0x00FF0000,0x0000FF00,0x000000FF,0);
+  if(target)
+  {
+    videobench_target(target,"sw32",sprites,alpha,rle,copies);
+    SDL_FreeSurface(target);
+  }
+
+  for(f=0;f<copies;f++)
+  {
+    SDL_FreeSurface(alpha[f]);
+    SDL_FreeSurface(rle[f]);
+  }
+  video_results.status=2;
+}
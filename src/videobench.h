@@ -0,0 +1,44 @@
+/*
+  RG350 Test
+  Video benchmarks: fills, blit paths and framebuffer copies measured
+  in Mpixels/s with the sprites loaded by the app, on the screen and
+  on hardware and software surfaces of 16 and 32 bpp.
+*/
+
+#ifndef VIDEOBENCH_H
+#define VIDEOBENCH_H
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <SDL/SDL.h>
+
+#define VIDEOBENCH_MAX  24
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct videobench_result
+{
+  char name[24];
+  double mpixels;     // Mpixels/s, 0 if not available
+};
+
+struct video_bench
+{
+  int status;         // 0=not run, 2=done
+  int count;
+  videobench_result results[VIDEOBENCH_MAX];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern video_bench video_results;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void videobench_run(SDL_Surface* screen);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  RG350 Test
+  Vsync test: every SDL_Flip() return is timestamped while the main loop
+  runs without frame limit, to find the refresh period of the panel, its
+  jitter, and if flips wait for the vertical blank.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <stdlib.h>
+#include <math.h>
+#include "vsynctest.h"
+
+#define VSYNC_MINPERIOD  5000   // us, flips faster than 200 Hz aren't waiting vblank
+#define VSYNC_MAXJITTER  0.1    // of the period, flips more irregular aren't locked
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+vsync_test vsync_results;
+
+///////////////////////////////////
+/*  Compare for qsort            */
+///////////////////////////////////
+static int vsync_compare(const void* a, const void* b)
+{
+  unsigned int va=*(const unsigned int*)a;
+  unsigned int vb=*(const unsigned int*)b;
+  return va<vb?-1:(va>vb?1:0);
+}
+
+///////////////////////////////////
+/*  Vblanks between two flips    */
+///////////////////////////////////
+static int vsync_periods(unsigned int interval, double period)
+{
+  int periods=(int)(interval/period+0.5);
+  return periods<1?1:periods;
+}
+
+///////////////////////////////////
+/*  Find period, jitter and      */
+/*  missed vblanks               */
+///////////////////////////////////
+static void vsynctest_analyze(vsync_test& test)
+{
+  unsigned int sorted[VSYNC_SAMPLES];
+  double total=0;
+  int f;
+
+  for(f=0;f<test.count;f++)
+  {
+    sorted[f]=test.intervals[f];
+    total+=test.intervals[f];
+  }
+  qsort(sorted,test.count,sizeof(unsigned int),vsync_compare);
+  test.flips=total>0?test.count*1000000.0/total:0;
+  test.locked=0;
+  test.period_us=0;
+  test.jitter_us=0;
+  test.missed=0;
+
+  // most flips take one vblank, the median is near the period
+  double median=sorted[test.count/2];
+  if(median<VSYNC_MINPERIOD)
+    return;
+
+  // period from the whole time and the vblanks counted, better than the median
+  int vblanks=0;
+  for(f=0;f<test.count;f++)
+    vblanks+=vsync_periods(test.intervals[f],median);
+  double period=total/vblanks;
+
+  double error=0;
+  for(f=0;f<test.count;f++)
+  {
+    int periods=vsync_periods(test.intervals[f],period);
+    double diff=test.intervals[f]-periods*period;
+    error+=diff*diff;
+    test.missed+=periods-1;
+  }
+  test.period_us=period;
+  test.jitter_us=sqrt(error/test.count);
+  test.locked=test.jitter_us<period*VSYNC_MAXJITTER;
+}
+
+///////////////////////////////////
+/*  Start measuring              */
+///////////////////////////////////
+void vsynctest_start(vsync_test& test)
+{
+  test.count=0;
+  test.last=0;
+  test.status=1;
+}
+
+///////////////////////////////////
+/*  Save the time of a flip      */
+///////////////////////////////////
+void vsynctest_flip(vsync_test& test, unsigned long long now)
+{
+  if(test.status!=1)
+    return;
+  if(test.last)
+    test.intervals[test.count++]=(unsigned int)(now-test.last);
+  test.last=now;
+  if(test.count==VSYNC_SAMPLES)
+  {
+    vsynctest_analyze(test);
+    test.status=2;
+  }
+}
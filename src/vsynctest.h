@@ -0,0 +1,40 @@
+/*
+  RG350 Test
+  Vsync test: every SDL_Flip() return is timestamped while the main loop
+  runs without frame limit, to find the refresh period of the panel, its
+  jitter, and if flips wait for the vertical blank.
+*/
+
+#ifndef VSYNCTEST_H
+#define VSYNCTEST_H
+
+#define VSYNC_SAMPLES  300   // flip intervals measured, 5 seconds at 60 Hz
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct vsync_test
+{
+  int status;             // 0=not run, 1=running, 2=done
+  int count;
+  unsigned long long last;    // time of the last flip
+  unsigned int intervals[VSYNC_SAMPLES];  // us between flips
+  int locked;             // flips wait for vblank
+  double period_us;       // refresh period, 0 if not locked
+  double jitter_us;       // deviation of flips from the vblanks
+  int missed;             // vblanks without flip
+  double flips;           // flips per second
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+extern vsync_test vsync_results;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+void vsynctest_start(vsync_test& test);
+void vsynctest_flip(vsync_test& test, unsigned long long now);
+
+#endif
@@ -0,0 +1,105 @@
+/*
+  RG350 Test
+  Stub of libshake for host builds (make HOST=1 or SHAKE_STUB=1): the
+  same types and functions, one fake device that doesn't rumble.
+*/
+
+///////////////////////////////////
+/*  Libraries                    */
+///////////////////////////////////
+#include <string.h>
+#include "shake.h"
+
+#define STUB_EFFECTS  16
+
+///////////////////////////////////
+/*  Structs                      */
+///////////////////////////////////
+struct Shake_Device
+{
+  int used[STUB_EFFECTS];
+};
+
+///////////////////////////////////
+/*  Globals                      */
+///////////////////////////////////
+static Shake_Device stub_device;
+
+///////////////////////////////////
+/*  Library and device           */
+///////////////////////////////////
+Shake_Status Shake_Init()
+{
+  return SHAKE_OK;
+}
+
+void Shake_Quit()
+{
+}
+
+int Shake_NumOfDevices()
+{
+  return 1;
+}
+
+Shake_Device* Shake_Open(unsigned int id)
+{
+  if(id!=0)
+    return NULL;
+  memset(&stub_device,0,sizeof(stub_device));
+  return &stub_device;
+}
+
+Shake_Status Shake_Close(Shake_Device* dev)
+{
+  return dev?SHAKE_OK:SHAKE_ERROR;
+}
+
+///////////////////////////////////
+/*  Effects                      */
+///////////////////////////////////
+Shake_Status Shake_InitEffect(Shake_Effect* effect, Shake_EffectType type)
+{
+  if(!effect || type<0 || type>=SHAKE_EFFECT_COUNT)
+    return SHAKE_ERROR;
+  memset(effect,0,sizeof(*effect));
+  effect->type=type;
+  effect->id=-1;
+  return SHAKE_OK;
+}
+
+int Shake_UploadEffect(Shake_Device* dev, Shake_Effect* effect)
+{
+  if(!dev || !effect)
+    return -1;
+  for(int f=0;f<STUB_EFFECTS;f++)
+  {
+    if(!dev->used[f])
+    {
+      dev->used[f]=1;
+      effect->id=f;
+      return f;
+    }
+  }
+  return -1;
+}
+
+Shake_Status Shake_EraseEffect(Shake_Device* dev, int id)
+{
+  if(!dev || id<0 || id>=STUB_EFFECTS || !dev->used[id])
+    return SHAKE_ERROR;
+  dev->used[id]=0;
+  return SHAKE_OK;
+}
+
+Shake_Status Shake_Play(Shake_Device* dev, int id)
+{
+  if(!dev || id<0 || id>=STUB_EFFECTS || !dev->used[id])
+    return SHAKE_ERROR;
+  return SHAKE_OK;
+}
+
+Shake_Status Shake_Stop(Shake_Device* dev, int id)
+{
+  return Shake_Play(dev,id);
+}
@@ -0,0 +1,120 @@
+/*
+  RG350 Test
+  Stub of libshake for host builds (make HOST=1 or SHAKE_STUB=1): the
+  same types and functions, one fake device that doesn't rumble.
+*/
+
+#ifndef SHAKE_H
+#define SHAKE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///////////////////////////////////
+/*  Types                        */
+///////////////////////////////////
+typedef struct Shake_Device Shake_Device;
+
+typedef enum
+{
+  SHAKE_ERROR=-1,
+  SHAKE_OK=0
+} Shake_Status;
+
+typedef enum
+{
+  SHAKE_EFFECT_RUMBLE=0,
+  SHAKE_EFFECT_PERIODIC,
+  SHAKE_EFFECT_CONSTANT,
+  SHAKE_EFFECT_SPRING,
+  SHAKE_EFFECT_FRICTION,
+  SHAKE_EFFECT_DAMPER,
+  SHAKE_EFFECT_INERTIA,
+  SHAKE_EFFECT_RAMP,
+  SHAKE_EFFECT_COUNT
+} Shake_EffectType;
+
+typedef enum
+{
+  SHAKE_PERIODIC_SQUARE=0,
+  SHAKE_PERIODIC_TRIANGLE,
+  SHAKE_PERIODIC_SINE,
+  SHAKE_PERIODIC_SAW_UP,
+  SHAKE_PERIODIC_SAW_DOWN,
+  SHAKE_PERIODIC_CUSTOM,
+  SHAKE_PERIODIC_COUNT
+} Shake_PeriodicWaveform;
+
+typedef struct Shake_Envelope
+{
+  int attackLength;
+  int attackLevel;
+  int fadeLength;
+  int fadeLevel;
+} Shake_Envelope;
+
+typedef struct Shake_EffectRumble
+{
+  int strongMagnitude;
+  int weakMagnitude;
+} Shake_EffectRumble;
+
+typedef struct Shake_EffectPeriodic
+{
+  Shake_PeriodicWaveform waveform;
+  int period;
+  int magnitude;
+  int offset;
+  int phase;
+  Shake_Envelope envelope;
+} Shake_EffectPeriodic;
+
+typedef struct Shake_EffectConstant
+{
+  int level;
+  Shake_Envelope envelope;
+} Shake_EffectConstant;
+
+typedef struct Shake_EffectRamp
+{
+  int startLevel;
+  int endLevel;
+  Shake_Envelope envelope;
+} Shake_EffectRamp;
+
+typedef struct Shake_Effect
+{
+  Shake_EffectType type;
+  int id;
+  int direction;
+  int length;
+  int delay;
+  union
+  {
+    Shake_EffectRumble rumble;
+    Shake_EffectPeriodic periodic;
+    Shake_EffectConstant constant;
+    Shake_EffectRamp ramp;
+  } u;
+} Shake_Effect;
+
+///////////////////////////////////
+/*  Function declarations        */
+///////////////////////////////////
+Shake_Status Shake_Init();
+void Shake_Quit();
+int Shake_NumOfDevices();
+Shake_Device* Shake_Open(unsigned int id);
+Shake_Status Shake_Close(Shake_Device* dev);
+Shake_Status Shake_InitEffect(Shake_Effect* effect, Shake_EffectType type);
+int Shake_UploadEffect(Shake_Device* dev, Shake_Effect* effect);
+Shake_Status Shake_EraseEffect(Shake_Device* dev, int id);
+Shake_Status Shake_Play(Shake_Device* dev, int id);
+Shake_Status Shake_Stop(Shake_Device* dev, int id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif